@@ -0,0 +1,17 @@
+#version 330 core
+
+in vec2 fragUV;
+in vec4 fragColor;
+
+uniform sampler2D image;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+	// the edge of the glyph is at 0.5, smooth it over a pixel
+	float distance = texture(image, fragUV).a;
+	float width = fwidth(distance);
+	float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+	outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
@@ -1,11 +1,19 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
 #include <stdexcept>
+#include <thread>
 
 #include <GLFW/glfw3.h>
 
 #include "application.hpp"
 
 #include "gameview.hpp"
+#include "utility.hpp"
 
 namespace
 {
@@ -15,10 +23,44 @@ const int MaxStepsPerFrame = 5;
 
 const unsigned ScreenWidth = 800;
 const unsigned ScreenHeight = 600;
+
+const unsigned LoopbackSampleRate = 48000;
+
+// low-latency mode: wake up this early before the estimated work
+const double WakeUpMargin = 0.002;
+const double WorkEstimateDecay = 0.95;
+
+const std::size_t TextureMemoryBudget = 64 * 1024 * 1024;
+const unsigned TextureIdleFrames = 10 * targetFPS;
+
+const char *FontCharset =
+	" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+	"[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+bool
+isInputEvent(const Event &event)
+{
+	return std::holds_alternative<KeyPressed>(event)
+		|| std::holds_alternative<KeyRepeated>(event)
+		|| std::holds_alternative<KeyReleased>(event)
+		|| std::holds_alternative<MouseButtonPressed>(event)
+		|| std::holds_alternative<MouseButtonReleased>(event)
+		|| std::holds_alternative<MouseCursorMoved>(event)
+		|| std::holds_alternative<MouseScrolled>(event)
+		|| std::holds_alternative<CodepointInput>(event);
+}
 }
 
-Application::Application()
+Application::Application(InputMode mode, const std::filesystem::path &inputFile,
+                         bool offlineAudio)
 	: mEventQueue()
+	, mInput()
+	, mRecorder()
+	, mReplay()
+	, mLatency()
+	, mLowLatency(false)
+	, mStatsReport(false)
+	, mWorkEstimate(0.0)
 	, mWindow()
 	, mRenderTarget()
 	, mAudioDevice()
@@ -27,10 +69,14 @@ Application::Application()
 	, mViewStack({
 			&mAudioDevice,
 			&mWindow,
+			&mInput,
+			&mEvents,
+			&mJobs,
 			&mRenderTarget,
 			&mFonts,
 			&mTextures,
 		})
+	, mJobs()
 {
 	if (!glfwInit())
 	{
@@ -42,16 +88,51 @@ Application::Application()
 	mWindow.open("RobotRampage", ScreenWidth, ScreenHeight);
 	mEventQueue.track(mWindow);
 	mRenderTarget.use(mWindow);
+	Texture::setMemoryBudget(TextureMemoryBudget, TextureIdleFrames);
 
-	if (!mAudioDevice.open(""))
+	if (offlineAudio)
+	{
+		if (!mAudioDevice.openLoopback(LoopbackSampleRate))
+		{
+			throw std::runtime_error("Cannot open the offline audio device");
+		}
+	}
+	else if (!mAudioDevice.open(""))
 	{
 		throw std::runtime_error("Cannot open the audio device");
 	}
 	mAudioDevice.setMasterVolume(30.f);
 
+	// a replay must run with the random sequence of the recording
+	unsigned seed = std::random_device()();
+	if (mode == InputMode::Replay)
+	{
+		if (!mReplay.open(inputFile))
+		{
+			throw std::runtime_error("Cannot read the input recording");
+		}
+		seed = mReplay.getSeed();
+	}
+	else if (mode == InputMode::Record && !mRecorder.open(inputFile, seed))
+	{
+		throw std::runtime_error("Cannot write the input recording");
+	}
+	Utility::setRandomSeed(seed);
+
 	loadAssets();
 	registerViews();
 
+	// default priority, below every view: quit when no view
+	// handles the key
+	mEvents.subscribe<KeyPressed>(this, [this](const KeyPressed &event) {
+		if (event.key != GLFW_KEY_ESCAPE)
+		{
+			return false;
+		}
+		mWindow.close();
+		return true;
+	});
+
 	// TODO: push the starting view
 	mViewStack.pushView(ViewID::Playing);
 	mViewStack.update(0.f);
@@ -59,6 +140,7 @@ Application::Application()
 
 Application::~Application()
 {
+	Font::setJobSystem(nullptr);
 	mTextures.destroy();
 	glfwTerminate();
 }
@@ -66,8 +148,14 @@ Application::~Application()
 void
 Application::loadAssets()
 {
+	auto cacheDirectory = Utility::getUserCacheDirectory();
+	if (!cacheDirectory.empty())
+	{
+		Font::setCacheDirectory(cacheDirectory / "robotrampage");
+	}
+	Font::setJobSystem(&mJobs);
 
-	mFonts.load(FontID::Pericles14, "assets/fonts/Peric.ttf", 14);
+	mFonts.load(FontID::Pericles14, "assets/fonts/Peric.ttf", 14, FontCharset);
 	mTextures.load(TextureID::TitleScreen, "assets/textures/TitleScreen.png");
 	mTextures.load(TextureID::SpriteSheet, "assets/textures/SpriteSheet.png");
 }
@@ -84,37 +172,143 @@ Application::processInput()
 	mEventQueue.poll();
 
 	Event event;
-	while (mEventQueue.pop(event))
+	double time;
+	while (mEventQueue.pop(event, time))
 	{
-		if (mViewStack.handleEvent(event))
+		if (!mReplay.isOpen())
 		{
-			// event handled by the view
+			if (isInputEvent(event))
+			{
+				mLatency.addInput(time);
+			}
+			if (mRecorder.isOpen())
+			{
+				mRecorder.record(event);
+			}
+			dispatch(event);
 		}
 		else if (const auto ep(std::get_if<KeyPressed>(&event)); ep
 		         && ep->key == GLFW_KEY_ESCAPE)
 		{
+			// the input comes from the recording, only quit
 			mWindow.close();
 		}
 	}
+
+	while (mReplay.isOpen() && mReplay.pop(event, &mWindow))
+	{
+		dispatch(event);
+	}
+}
+
+void
+Application::dispatch(const Event &event)
+{
+	mInput.handleEvent(event);
+	mViewStack.handleEvent(event);
+}
+
+void
+Application::setLowLatency(bool enable)
+{
+	mLowLatency = enable;
+}
+
+void
+Application::setStatsReport(bool enable)
+{
+	mStatsReport = enable;
+}
+
+void
+Application::waitForInput(double presentTime)
+{
+	// the next present is a frame away from the last one, poll
+	// the input just in time to do the work of the frame
+	double wakeUp = presentTime + SecondsPerFrame - mWorkEstimate - WakeUpMargin;
+	double delay = wakeUp - glfwGetTime();
+	if (delay > 0.0)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+	}
 }
 
 void
 Application::run()
 {
-	// variable-time game loop
+	// fixed-time game loop, the render interpolates between the
+	// last two updates
 	auto currentTime = glfwGetTime();
+	auto presentTime = currentTime;
+	float accumulator = 0.f;
+	double audioFrames = 0.0;
 	while (!mWindow.isClosed() && !mViewStack.empty())
 	{
+		if (mLowLatency)
+		{
+			waitForInput(presentTime);
+		}
+
 		auto newTime = glfwGetTime();
-		auto frameTime = newTime - currentTime;
+		float frameTime = newTime - currentTime;
 		currentTime = newTime;
 
+		if (mReplay.isOpen() && !mReplay.nextFrame(frameTime))
+		{
+			// end of the recording
+			break;
+		}
+		if (mRecorder.isOpen())
+		{
+			mRecorder.beginFrame(frameTime);
+		}
+
+		mLatency.beginFrame();
 		processInput();
-		mViewStack.update(frameTime);
-		mAudioDevice.update();
+
+		accumulator += frameTime;
+		int steps = 0;
+		while (accumulator >= SecondsPerFrame && steps < MaxStepsPerFrame
+		       && !mViewStack.empty())
+		{
+			mViewStack.update(SecondsPerFrame);
+			mInput.endStep();
+			accumulator -= SecondsPerFrame;
+			steps++;
+		}
+		if (accumulator >= SecondsPerFrame)
+		{
+			// too slow to catch up, drop the time left behind
+			accumulator = std::fmod(accumulator, SecondsPerFrame);
+		}
+		mLatency.mark(LatencyStats::Stage::Update, glfwGetTime());
+		if (mAudioDevice.isLoopback())
+		{
+			// offline audio, mix the time of the frame and carry
+			// the fraction of a sample to the next one
+			audioFrames += frameTime * mAudioDevice.getSampleRate();
+			double whole = std::floor(audioFrames);
+			audioFrames -= whole;
+			mAudioDevice.render(static_cast<unsigned>(whole));
+		}
 
 		// render
-		mViewStack.render(mRenderTarget);
+		mViewStack.render(mRenderTarget, accumulator / SecondsPerFrame);
+		auto renderedTime = glfwGetTime();
+		mLatency.mark(LatencyStats::Stage::Render, renderedTime);
+		mWorkEstimate = std::max(renderedTime - newTime,
+		                         mWorkEstimate * WorkEstimateDecay);
+
 		mWindow.display();
+		presentTime = glfwGetTime();
+		mLatency.mark(LatencyStats::Stage::Present, presentTime);
+		Texture::endFrame();
+		mJobs.endFrame();
+	}
+
+	if (mStatsReport)
+	{
+		mLatency.report(std::cout);
+		mJobs.report(std::cout);
 	}
 }
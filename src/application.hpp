@@ -1,8 +1,13 @@
 #pragma once
 
 #include "audiodevice.hpp"
+#include "eventdispatcher.hpp"
 #include "eventqueue.hpp"
 #include "font.hpp"
+#include "inputrecord.hpp"
+#include "inputstate.hpp"
+#include "jobsystem.hpp"
+#include "latencystats.hpp"
 #include "rendertarget.hpp"
 #include "resourceholder.hpp"
 #include "resources.hpp"
@@ -13,22 +18,62 @@
 class Application
 {
 public:
-	Application();
+	enum class InputMode
+	{
+		Live,    // input from the devices
+		Record,  // input from the devices, saved to the file
+		Replay,  // input from the file
+	};
+
+public:
+	/**
+	 * With @offlineAudio the sound is mixed in memory by the loop
+	 * instead of being played on the sound hardware.
+	 */
+	explicit Application(InputMode mode = InputMode::Live,
+	                     const std::filesystem::path &inputFile = {},
+	                     bool offlineAudio = false);
 	~Application();
 
+	/**
+	 * In low-latency mode the loop sleeps before polling the input,
+	 * as close to the next present as the estimated work of a frame
+	 * allows, instead of polling it right after the present.
+	 */
+	void setLowLatency(bool enable);
+
+	/**
+	 * Print the input latency and the utilization of the job
+	 * workers when run() returns.
+	 */
+	void setStatsReport(bool enable);
+
 	void run();
 
 private:
 	void loadAssets();
 	void registerViews();
 	void processInput();
+	void waitForInput(double presentTime);
+	void dispatch(const Event &event);
 
 private:
 	EventQueue mEventQueue;
+	EventDispatcher mEvents;
+	InputState mInput;
+	InputRecorder mRecorder;
+	InputReplay mReplay;
+	LatencyStats mLatency;
+	bool mLowLatency;
+	bool mStatsReport;
+	double mWorkEstimate;
 	Window mWindow;
 	RenderTarget mRenderTarget;
 	AudioDevice mAudioDevice;
 	FontHolder mFonts;
 	TextureHolder mTextures;
 	ViewStack mViewStack;
+
+	// destroyed first, the jobs left can still use the rest
+	JobSystem mJobs;
 };
@@ -1,11 +1,42 @@
-#include <fstream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <exception>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "alcheck.hpp"
 #include "audiodevice.hpp"
+#include "resampler.hpp"
+#include "utility.hpp"
 
 namespace
 {
+// number of voices preallocated when the device is opened
+const unsigned VoiceCount = 32;
+
+// how often the audio thread runs the commands and polls the voices
+const auto AudioThreadPeriod = std::chrono::milliseconds(5);
+
+// throttling of a sound unless overridden with setLimits()
+const unsigned DefaultMaxInstances = 4;
+const auto DefaultMinInterval = std::chrono::milliseconds(30);
+
+// gain limit for the merged plays of the same sound
+const float MaxMergedGain = 2.f;
+
+// positional sounds farther than this are not played, the listener
+// hovers over the plane of the world to avoid hard panning
+const float AudibleRadius = 800.f;
+const float ListenerHeight = 200.f;
+
 struct WaveMasterChunk
 {
 	char          chunkId[4];
@@ -30,6 +61,330 @@ struct WaveFormatChunk
 	std::uint32_t dwChannelMask;
 	char          SubFormat[16];
 };
+
+// variants of every sound, the first one is the original
+struct SoundVariant
+{
+	float pitch;
+	float gain;
+	float lowpass;  // one-pole coefficient, zero is no filter
+};
+const SoundVariant SoundVariants[] = {
+	{ 1.00f, 1.00f, 0.00f },
+	{ 0.94f, 0.95f, 0.20f },
+	{ 1.06f, 0.90f, 0.00f },
+	{ 0.89f, 0.85f, 0.35f },
+};
+
+// WAVE_FORMAT_* tags
+const std::uint16_t WaveFormatPCM = 1;
+const std::uint16_t WaveFormatFloat = 3;
+const std::uint16_t WaveFormatExtensible = 0xFFFE;
+
+/**
+ * WAV file mapped in memory and normalized to mono 16-bit samples at
+ * the rate of the device. The samples point straight into the mapping
+ * when the file is already in that format.
+ */
+class WaveFile
+{
+public:
+	WaveFile() = default;
+	~WaveFile();
+
+	WaveFile(const WaveFile &) = delete;
+	WaveFile& operator=(const WaveFile &) = delete;
+
+	/**
+	 * Map the file, parse its chunks, convert the samples to
+	 * @sampleRate (zero keeps the rate of the file) and render the
+	 * first @variants entries of SoundVariants.
+	 */
+	bool open(const std::filesystem::path &path, unsigned sampleRate,
+	          unsigned variants);
+
+	const char *getSamples() const { return mSamples; }
+	std::size_t getSampleSize() const { return mSampleSize; }
+	unsigned getSampleRate() const { return mSampleRate; }
+
+	unsigned getVariantCount() const;
+	std::span<const std::int16_t> getVariant(unsigned index) const;
+
+private:
+	bool parse();
+	void convert(unsigned sampleRate);
+	void makeVariants(unsigned variants);
+
+private:
+	void *mMapping = nullptr;
+	std::size_t mSize = 0;
+	const char *mSamples = nullptr;
+	std::size_t mSampleSize = 0;
+	unsigned mChannels = 0;
+	unsigned mBitsPerSample = 0;
+	bool mFloat = false;
+	unsigned mSampleRate = 0;
+	std::vector<std::int16_t> mConverted;
+	std::vector<std::vector<std::int16_t>> mVariants;
+};
+
+float
+decodeSample(const unsigned char *p, unsigned bytes, bool isFloat)
+{
+	if (isFloat)
+	{
+		if (bytes == 8)
+		{
+			double value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		float value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	switch (bytes)
+	{
+	case 1:
+		return (p[0] - 128) / 128.f;
+	case 2:
+		return static_cast<std::int16_t>(p[0] | p[1] << 8) / 32768.f;
+	case 3:
+		return static_cast<std::int32_t>(
+			static_cast<std::uint32_t>(p[0]) << 8
+			| static_cast<std::uint32_t>(p[1]) << 16
+			| static_cast<std::uint32_t>(p[2]) << 24) / 2147483648.f;
+	default:
+		std::int32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value / 2147483648.f;
+	}
+}
+
+WaveFile::~WaveFile()
+{
+	if (mMapping)
+	{
+		munmap(mMapping, mSize);
+	}
+}
+
+bool
+WaveFile::open(const std::filesystem::path &path, unsigned sampleRate,
+               unsigned variants)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return false;
+	}
+	mMapping = mapping;
+	mSize = st.st_size;
+	if (!parse())
+	{
+		return false;
+	}
+	convert(sampleRate ? sampleRate : mSampleRate);
+	makeVariants(variants);
+	return true;
+}
+
+void
+WaveFile::makeVariants(unsigned variants)
+{
+	auto base = reinterpret_cast<const unsigned char *>(mSamples);
+	const std::size_t count = mSampleSize / 2;
+	std::vector<float> samples(count);
+	for (unsigned v = 1; v < variants; ++v)
+	{
+		const auto &variant = SoundVariants[v];
+
+		// filter and scale, then resample to bake the pitch
+		float y = 0.f;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			float x = decodeSample(base + i * 2, 2, false);
+			y = (1.f - variant.lowpass) * x + variant.lowpass * y;
+			samples[i] = y * variant.gain;
+		}
+		auto pitched = Resampler::resample(samples, 1.0 / variant.pitch);
+
+		auto &out = mVariants.emplace_back(pitched.size());
+		for (std::size_t i = 0; i < pitched.size(); ++i)
+		{
+			out[i] = std::lrint(std::clamp(pitched[i], -1.f, 1.f) * 32767.f);
+		}
+	}
+}
+
+unsigned
+WaveFile::getVariantCount() const
+{
+	return mVariants.size() + 1;
+}
+
+std::span<const std::int16_t>
+WaveFile::getVariant(unsigned index) const
+{
+	if (index == 0)
+	{
+		return {
+			reinterpret_cast<const std::int16_t *>(mSamples),
+			mSampleSize / 2
+		};
+	}
+	return mVariants[index - 1];
+}
+
+void
+WaveFile::convert(unsigned sampleRate)
+{
+	if (mChannels == 1 && mBitsPerSample == 16 && !mFloat
+	    && mSampleRate == sampleRate)
+	{
+		// already in the right format, touch every page of the
+		// samples so that the upload doesn't wait on the disk
+		madvise(mMapping, mSize, MADV_WILLNEED);
+		const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+		volatile char sink = 0;
+		for (std::size_t i = 0; i < mSampleSize; i += pageSize)
+		{
+			sink = sink + mSamples[i];
+		}
+		return;
+	}
+
+	// mix down to mono, OpenAL positions only mono sources
+	const unsigned bytes = mBitsPerSample / 8;
+	const std::size_t frames = mSampleSize / (bytes * mChannels);
+	std::vector<float> mono(frames);
+	auto p = reinterpret_cast<const unsigned char *>(mSamples);
+	for (auto &sample : mono)
+	{
+		float sum = 0.f;
+		for (unsigned c = 0; c < mChannels; ++c, p += bytes)
+		{
+			sum += decodeSample(p, bytes, mFloat);
+		}
+		sample = sum / mChannels;
+	}
+
+	// resample once here instead of on every voice
+	if (mSampleRate != sampleRate)
+	{
+		mono = Resampler::resample(
+			mono, static_cast<double>(sampleRate) / mSampleRate);
+	}
+
+	mConverted.resize(mono.size());
+	for (std::size_t i = 0; i < mono.size(); ++i)
+	{
+		mConverted[i] = std::lrint(std::clamp(mono[i], -1.f, 1.f) * 32767.f);
+	}
+	mSamples = reinterpret_cast<const char *>(mConverted.data());
+	mSampleSize = mConverted.size() * sizeof(mConverted[0]);
+	mSampleRate = sampleRate;
+}
+
+bool
+WaveFile::parse()
+{
+	auto data = static_cast<const char *>(mMapping);
+
+	WaveMasterChunk master;
+	if (mSize < sizeof(master))
+	{
+		return false;
+	}
+	std::memcpy(&master, data, sizeof(master));
+	if (!std::equal(master.chunkId, master.chunkId+4, "RIFF")
+	    || !std::equal(master.waveId, master.waveId+4, "WAVE"))
+	{
+		return false;
+	}
+
+	// walk the chunks we are interested in
+	std::size_t offset = sizeof(master);
+	WaveChunkHeader header;
+	while (offset + sizeof(header) <= mSize)
+	{
+		std::memcpy(&header, data + offset, sizeof(header));
+		offset += sizeof(header);
+		if (header.chunkSize > mSize - offset)
+		{
+			std::cerr << "the WAV file is truncated.\n";
+			return false;
+		}
+
+		if (std::equal(header.chunkId+0, header.chunkId+4, "fmt "))
+		{
+			WaveFormatChunk fmt{};
+			if (header.chunkSize < offsetof(WaveFormatChunk, cbSize))
+			{
+				std::cerr << "cannot read the format of the WAV file.\n";
+				return false;
+			}
+			std::memcpy(&fmt, data + offset,
+			            std::min<std::size_t>(header.chunkSize, sizeof(fmt)));
+
+			// the extensible format stores the tag in the GUID
+			std::uint16_t tag = fmt.wFormatTag;
+			if (tag == WaveFormatExtensible)
+			{
+				if (header.chunkSize < sizeof(fmt))
+				{
+					std::cerr << "cannot read the format of the WAV file.\n";
+					return false;
+				}
+				std::memcpy(&tag, fmt.SubFormat, sizeof(tag));
+			}
+
+			mChannels = fmt.nChannels;
+			mBitsPerSample = fmt.nBitsPerSample;
+			mFloat = tag == WaveFormatFloat;
+			mSampleRate = fmt.nSamplesPerSec;
+			bool supported = mFloat
+				? mBitsPerSample == 32 || mBitsPerSample == 64
+				: mBitsPerSample == 8 || mBitsPerSample == 16
+				  || mBitsPerSample == 24 || mBitsPerSample == 32;
+			if ((tag != WaveFormatPCM && tag != WaveFormatFloat)
+			    || !supported || mChannels == 0 || mSampleRate == 0
+			    || fmt.bBlockAlign != mChannels * mBitsPerSample / 8)
+			{
+				std::cerr << "unsupported WAV sample format.\n";
+				return false;
+			}
+		}
+		else if (std::equal(header.chunkId, header.chunkId+4, "data"))
+		{
+			if (!mChannels)
+			{
+				std::cerr << "missing WAV format.\n";
+				return false;
+			}
+			mSamples = data + offset;
+			mSampleSize = header.chunkSize;
+			return true;
+		}
+
+		// skip the rest of the chunk and its padding
+		offset += header.chunkSize + (header.chunkSize & 1);
+	}
+	return false;
+}
 }
 
 std::vector<std::string>
@@ -61,22 +416,27 @@ AudioDevice::enumerate()
 AudioDevice::AudioDevice()
 	: mAudioDevice(nullptr)
 	, mAudioContext(nullptr)
+	, mSampleRate(0)
 	, mMasterVolume(0.f)
+	, mVoices()
+	, mFreeVoices()
+	, mPlayCount(0)
+	, mSounds()
+	, mMusic()
+	, mRenderSamples(nullptr)
+	, mRenderBuffer()
+	, mThrottles()
+	, mPending()
+	, mListenerPosition(0.f, 0.f)
+	, mCommands()
+	, mThread()
+	, mRunning(false)
 {
 }
 
 AudioDevice::~AudioDevice()
 {
-	for (auto source : mPlayingSources)
-	{
-		alCheck(alSourceStop(source));
-	}
-	alCheck(alDeleteSources(mPlayingSources.size(), mPlayingSources.data()));
-	alCheck(alDeleteSources(mStoppedSources.size(), mStoppedSources.data()));
-	for (auto [_, buffer] : mBuffers)
-	{
-		alCheck(alDeleteBuffers(1, &buffer));
-	}
+	close();
 }
 
 bool
@@ -105,19 +465,148 @@ AudioDevice::open(const std::string &name)
 		alcCloseDevice(device);
 		return false;
 	}
+	if (!initialize(device, context, name))
+	{
+		return false;
+	}
+
+	mRunning = true;
+	mThread = std::thread(&AudioDevice::run, this);
+	return true;
+}
+
+bool
+AudioDevice::openLoopback(unsigned sampleRate)
+{
+	close();
+	auto loopbackOpenDevice = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(
+		alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+	if (!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback") || !loopbackOpenDevice)
+	{
+		std::cerr << "AudioDevice::openLoopback() - ALC_SOFT_loopback not supported.\n";
+		return false;
+	}
+
+	auto device = loopbackOpenDevice(nullptr);
+	if (!device)
+	{
+		std::cerr << "AudioDevice::openLoopback() - cannot open the device.\n";
+		return false;
+	}
+
+	auto isRenderFormatSupported = reinterpret_cast<LPALCISRENDERFORMATSUPPORTEDSOFT>(
+		alcGetProcAddress(device, "alcIsRenderFormatSupportedSOFT"));
+	auto renderSamples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(
+		alcGetProcAddress(device, "alcRenderSamplesSOFT"));
+	if (!isRenderFormatSupported || !renderSamples
+	    || !isRenderFormatSupported(device, sampleRate, ALC_STEREO_SOFT, ALC_FLOAT_SOFT))
+	{
+		std::cerr << "AudioDevice::openLoopback() - unsupported format at "
+		          << sampleRate << " Hz.\n";
+		alcCloseDevice(device);
+		return false;
+	}
 
+	const ALCint attributes[] = {
+		ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+		ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+		ALC_FREQUENCY, static_cast<ALCint>(sampleRate),
+		0
+	};
+	auto context = alcCreateContext(device, attributes);
+	if (!context)
+	{
+		std::cerr << "AudioDevice::openLoopback() - cannot create a context.\n";
+		alcCloseDevice(device);
+		return false;
+	}
+	if (!initialize(device, context, "loopback"))
+	{
+		return false;
+	}
+	mRenderSamples = renderSamples;
+	return true;
+}
+
+bool
+AudioDevice::initialize(ALCdevice *device, ALCcontext *context, const std::string &name)
+{
 	mAudioDevice = device;
 	mAudioContext = context;
 	alcMakeContextCurrent(context);
 
+	int sampleRate;
+	alcGetIntegerv(device, ALC_FREQUENCY, 1, &sampleRate);
+	mSampleRate = sampleRate;
+
 	// apply the set values
 	alCheck(alListenerf(AL_GAIN, mMasterVolume * 0.01f));
+
+	// the listener looks down at the world with the y axis
+	// pointing to the bottom of the screen
+	const float orientation[] = { 0.f, 0.f, 1.f, 0.f, -1.f, 0.f };
+	alCheck(alListenerfv(AL_ORIENTATION, orientation));
+	alCheck(alListener3f(AL_POSITION, mListenerPosition.x, mListenerPosition.y,
+	                     -ListenerHeight));
+	alCheck(alDistanceModel(AL_LINEAR_DISTANCE_CLAMPED));
+
+	// preallocate the voices, the implementation may offer less
+	mVoices.reserve(VoiceCount);
+	mFreeVoices.reserve(VoiceCount);
+	while (mVoices.size() < VoiceCount)
+	{
+		unsigned source;
+		alGenSources(1, &source);
+		if (alGetError() != AL_NO_ERROR)
+		{
+			break;
+		}
+		mFreeVoices.push_back(mVoices.size());
+		alCheck(alSourcef(source, AL_MAX_GAIN, MaxMergedGain));
+		alCheck(alSourcef(source, AL_REFERENCE_DISTANCE, ListenerHeight));
+		alCheck(alSourcef(source, AL_MAX_DISTANCE,
+		                  std::hypot(AudibleRadius, ListenerHeight)));
+		mVoices.push_back({source, SoundID(), 0, 0.f, 0, false});
+	}
+	if (mVoices.empty())
+	{
+		std::cerr << "AudioDevice::open(\"" << name
+		          << "\") - cannot allocate the voices.\n";
+		close();
+		return false;
+	}
 	return true;
 }
 
 void
 AudioDevice::close()
 {
+	mRunning = false;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	// drop the commands queued after the last iteration
+	Command command;
+	while (mCommands.pop(command))
+	{
+	}
+	mThrottles.clear();
+	mPending.clear();
+
+	mRenderSamples = nullptr;
+	mRenderBuffer.clear();
+	if (mAudioContext)
+	{
+		mMusic.close();
+		releaseVoices();
+		for (auto [_, sound] : mSounds)
+		{
+			alCheck(alDeleteBuffers(sound.buffers.size(), sound.buffers.data()));
+		}
+		mSounds.clear();
+	}
 	alcMakeContextCurrent(nullptr);
 	if (mAudioContext)
 	{
@@ -131,6 +620,29 @@ AudioDevice::close()
 	}
 }
 
+bool
+AudioDevice::isLoopback() const
+{
+	return mRenderSamples != nullptr;
+}
+
+unsigned
+AudioDevice::getSampleRate() const
+{
+	return mSampleRate;
+}
+
+std::span<const float>
+AudioDevice::render(unsigned frames)
+{
+	assert(isLoopback() && "Rendering requires a loopback device");
+
+	process();
+	mRenderBuffer.resize(frames * 2);
+	mRenderSamples(mAudioDevice, mRenderBuffer.data(), frames);
+	return mRenderBuffer;
+}
+
 float
 AudioDevice::getMasterVolume() const
 {
@@ -151,9 +663,116 @@ AudioDevice::setMasterVolume(float value)
 		value = 100.f;
 	}
 	mMasterVolume = value * 0.01f;
-	if (mAudioDevice != nullptr && mAudioContext != nullptr)
+	if (mAudioContext)
+	{
+		push(VolumeCommand{mMasterVolume});
+	}
+}
+
+void
+AudioDevice::push(Command &&command)
+{
+	if (!mCommands.push(std::move(command)))
+	{
+		std::cerr << "AudioDevice::push() failed - queue full, command lost\n";
+	}
+}
+
+void
+AudioDevice::run()
+{
+	while (mRunning)
+	{
+		process();
+		std::this_thread::sleep_for(AudioThreadPeriod);
+	}
+}
+
+void
+AudioDevice::process()
+{
+	Command command;
+	while (mCommands.pop(command))
+	{
+		std::visit([this](const auto &cmd) { execute(cmd); }, command);
+	}
+	startPending();
+	updateVoices();
+}
+
+void
+AudioDevice::releaseVoices()
+{
+	for (const auto &voice : mVoices)
+	{
+		alCheck(alSourceStop(voice.source));
+		alCheck(alDeleteSources(1, &voice.source));
+	}
+	mVoices.clear();
+	mFreeVoices.clear();
+}
+
+unsigned
+AudioDevice::findVoice(int priority)
+{
+	if (!mFreeVoices.empty())
+	{
+		unsigned index = mFreeVoices.back();
+		mFreeVoices.pop_back();
+		return index;
+	}
+
+	// steal the lowest priority voice, then the quietest and
+	// then the oldest
+	unsigned victim = -1U;
+	for (unsigned i = 0; i < mVoices.size(); ++i)
+	{
+		const auto &voice = mVoices[i];
+		if (voice.priority > priority)
+		{
+			continue;
+		}
+		if (victim == -1U)
+		{
+			victim = i;
+			continue;
+		}
+		const auto &best = mVoices[victim];
+		if (voice.priority != best.priority)
+		{
+			if (voice.priority < best.priority)
+			{
+				victim = i;
+			}
+		}
+		else if (voice.gain != best.gain)
+		{
+			if (voice.gain < best.gain)
+			{
+				victim = i;
+			}
+		}
+		else if (voice.started < best.started)
+		{
+			victim = i;
+		}
+	}
+	if (victim != -1U)
 	{
-		alCheck(alListenerf(AL_GAIN, mMasterVolume));
+		alCheck(alSourceStop(mVoices[victim].source));
+		stopVoice(victim);
+	}
+	return victim;
+}
+
+void
+AudioDevice::stopVoice(unsigned index)
+{
+	auto &voice = mVoices[index];
+	voice.playing = false;
+	if (auto found = mThrottles.find(voice.sound); found != mThrottles.end())
+	{
+		found->second.instances--;
 	}
 }
 
@@ -161,155 +780,342 @@ void
 AudioDevice::play(SoundID soundId)
 {
         // find the sound id
-	auto found = mBuffers.find(soundId);
-	if (found == mBuffers.end())
+	auto found = mSounds.find(soundId);
+	if (found == mSounds.end())
 	{
 		std::cerr << "AudioDevice::play(" << static_cast<int>(soundId)
 		          << ") - sound id not found\n";
 		return;
 	}
+	unsigned variant = Utility::randomInt(VARIANT_COUNT);
+	push(PlayCommand{soundId, found->second, variant, false, {0.f, 0.f}});
+}
 
-	// get an available source
-	unsigned source;
-	if (!mStoppedSources.empty())
+void
+AudioDevice::play(SoundID soundId, glm::vec2 position)
+{
+	auto found = mSounds.find(soundId);
+	if (found == mSounds.end())
 	{
-		source = mStoppedSources.back();
-		mStoppedSources.pop_back();
+		std::cerr << "AudioDevice::play(" << static_cast<int>(soundId)
+		          << ") - sound id not found\n";
+		return;
 	}
-	else
+	unsigned variant = Utility::randomInt(VARIANT_COUNT);
+	push(PlayCommand{soundId, found->second, variant, true, position});
+}
+
+void
+AudioDevice::setListenerPosition(glm::vec2 position)
+{
+	push(ListenerCommand{position});
+}
+
+void
+AudioDevice::stopAll()
+{
+	push(StopAllCommand{});
+}
+
+void
+AudioDevice::execute(const PlayCommand &command)
+{
+	// merge with the plays of the same sound in this iteration
+	// keeping the one closest to the listener
+	auto &throttle = mThrottles[command.id];
+	if (throttle.pending++ == 0)
 	{
-		alCheck(alGenSources(1, &source));
+		throttle.command = command;
+		mPending.push_back(command.id);
 	}
+	else if (getDistance(command) < getDistance(throttle.command))
+	{
+		throttle.command = command;
+	}
+}
 
-	// bind the buffer
-	alCheck(alSourcei(source, AL_BUFFER, found->second));
-	alCheck(alSourcePlay(source));
-	mPlayingSources.push_back(source);
+float
+AudioDevice::getDistance(const PlayCommand &command) const
+{
+	return command.positional
+		? glm::length(command.position - mListenerPosition)
+		: 0.f;
 }
 
 void
-AudioDevice::update()
+AudioDevice::startPending()
 {
-	// NOTE: removing elements invalidates references, pointers
-	// and iterators that refer to the following elements: we are
-	// safe since pop_back() removes previous elements.
-	for (auto it = mPlayingSources.rbegin(), end = mPlayingSources.rend();
-	     it != end; it++)
+	auto now = Clock::now();
+	for (auto id : mPending)
 	{
+		auto &throttle = mThrottles[id];
+		const auto &command = throttle.command;
+		const auto &sound = command.sound;
+		unsigned count = throttle.pending;
+		throttle.pending = 0;
+
+		float distance = getDistance(command);
+		if (distance > AudibleRadius
+		    || (sound.maxInstances && throttle.instances >= sound.maxInstances)
+		    || (throttle.instances && now - throttle.lastStart < sound.minInterval))
+		{
+			continue;
+		}
+
+		// get an available voice, drop the sound if every voice
+		// is busy with more important ones
+		unsigned index = findVoice(sound.priority);
+		if (index == -1U)
+		{
+			continue;
+		}
+
+		// bind the buffer, the merged plays add up in power
+		float gain = std::min(std::sqrt(static_cast<float>(count)), MaxMergedGain);
+		auto &voice = mVoices[index];
+		voice.sound = id;
+		voice.priority = sound.priority;
+		voice.gain = gain * (1.f - distance / AudibleRadius);
+		voice.started = mPlayCount++;
+		voice.playing = true;
+		alCheck(alSourcei(voice.source, AL_BUFFER, sound.buffers[command.variant]));
+		alCheck(alSourcef(voice.source, AL_GAIN, gain));
+		if (command.positional)
+		{
+			alCheck(alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_FALSE));
+			alCheck(alSource3f(voice.source, AL_POSITION,
+			                   command.position.x, command.position.y, 0.f));
+		}
+		else
+		{
+			// the listener sits at the reference distance
+			alCheck(alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_TRUE));
+			alCheck(alSource3f(voice.source, AL_POSITION, 0.f, 0.f, 0.f));
+		}
+		alCheck(alSourcePlay(voice.source));
+
+		throttle.instances++;
+		throttle.lastStart = now;
+	}
+	mPending.clear();
+}
+
+void
+AudioDevice::execute(const StopAllCommand &)
+{
+	for (unsigned i = 0; i < mVoices.size(); ++i)
+	{
+		auto &voice = mVoices[i];
+		if (voice.playing)
+		{
+			alCheck(alSourceStop(voice.source));
+			stopVoice(i);
+			mFreeVoices.push_back(i);
+		}
+	}
+}
+
+void
+AudioDevice::execute(const VolumeCommand &command)
+{
+	alCheck(alListenerf(AL_GAIN, command.volume));
+}
+
+void
+AudioDevice::execute(const ListenerCommand &command)
+{
+	mListenerPosition = command.position;
+	alCheck(alListener3f(AL_POSITION, command.position.x, command.position.y,
+	                     -ListenerHeight));
+}
+
+void
+AudioDevice::execute(const PlayMusicCommand &command)
+{
+	if (!mMusic.openFromFile(command.path))
+	{
+		std::cerr << "AudioDevice::playMusic() - failed to load \""
+		          << command.path << "\".\n";
+		return;
+	}
+	mMusic.setLoop(command.loop);
+	mMusic.play();
+}
+
+void
+AudioDevice::execute(const StopMusicCommand &)
+{
+	mMusic.stop();
+}
+
+void
+AudioDevice::updateVoices()
+{
+	// the cost is bound by the size of the pool
+	for (unsigned i = 0; i < mVoices.size(); ++i)
+	{
+		auto &voice = mVoices[i];
+		if (!voice.playing)
+		{
+			continue;
+		}
 		int status;
-		alCheck(alGetSourcei(*it, AL_SOURCE_STATE, &status));
+		alCheck(alGetSourcei(voice.source, AL_SOURCE_STATE, &status));
 		if (status == AL_STOPPED)
 		{
-			mStoppedSources.push_back(*it);
-			*it = mPlayingSources.back();
-			mPlayingSources.pop_back();
+			stopVoice(i);
+			mFreeVoices.push_back(i);
 		}
 	}
 }
 
-static unsigned
-loadWav(const std::filesystem::path &path)
+static bool
+uploadWav(const WaveFile &wave, std::span<unsigned> buffers)
 {
-	std::ifstream file(path, std::ios::in|std::ios::binary);
-	if (!file)
+	alCheck(alGenBuffers(buffers.size(), buffers.data()));
+	for (unsigned i = 0; i < buffers.size(); ++i)
 	{
-		return 0;
+		auto samples = wave.getVariant(i);
+		alBufferData(buffers[i], AL_FORMAT_MONO16,
+		             samples.data(), samples.size_bytes(),
+		             wave.getSampleRate());
+		if (alGetError())
+		{
+			std::cerr << "cannot upload the samples.\n";
+			alDeleteBuffers(buffers.size(), buffers.data());
+			return false;
+		}
 	}
+	return true;
+}
 
-	WaveMasterChunk master;
-	if (!file.read(reinterpret_cast<char*>(&master), sizeof(master))
-	    || !std::equal(master.chunkId, master.chunkId+4, "RIFF")
-	    || !std::equal(master.waveId, master.waveId+4, "WAVE"))
+bool
+AudioDevice::load(SoundID id, const std::filesystem::path &path)
+{
+	WaveFile wave;
+	std::array<unsigned, VARIANT_COUNT> buffers;
+	bool loaded = wave.open(path, mSampleRate, buffers.size())
+		&& uploadWav(wave, buffers);
+	return addSound(id, loaded ? buffers : std::span<const unsigned>(), path);
+}
+
+bool
+AudioDevice::loadAll(JobSystem &jobs,
+                     const std::vector<std::pair<SoundID, std::filesystem::path>> &sounds)
+{
+	// map, parse, convert and make the variants of the files in
+	// parallel, OpenAL gets the uploads one at a time
+	std::vector<WaveFile> waves(sounds.size());
+	std::vector<char> parsed(sounds.size(), false);
+	std::vector<JobSystem::Handle> handles;
+	handles.reserve(sounds.size());
+	for (std::size_t i = 0; i < sounds.size(); ++i)
 	{
-		return 0;
+		handles.push_back(jobs.schedule(
+			[&wave = waves[i], &ok = parsed[i], &path = sounds[i].second,
+			 rate = mSampleRate] {
+				ok = wave.open(path, rate, VARIANT_COUNT);
+			}));
 	}
 
-	// read the chunks we are interested in
-	unsigned sampleFormat = 0;
-	unsigned sampleRate = 0;
-	WaveChunkHeader header;
-	while (file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+	// wait for every job even after an exception, they write into
+	// waves and parsed
+	bool success = true;
+	std::exception_ptr error;
+	for (std::size_t i = 0; i < sounds.size(); ++i)
 	{
-		if (std::equal(header.chunkId+0, header.chunkId+4, "fmt "))
+		try
 		{
-			WaveFormatChunk fmt;
-			if (!file.read(reinterpret_cast<char *>(&fmt), header.chunkSize))
-			{
-				std::cerr << "cannot read the format of the WAV file.\n";
-				return 0;
-			}
-			if (fmt.wFormatTag != 1)
-			{
-				std::cerr << "cannot read non-PCM WAV files.\n";
-				return 0;
-			}
-
-			// decode the format of the samples
-			switch (fmt.nChannels)
-			{
-			case 1: sampleFormat = AL_FORMAT_MONO16; break;
-			case 2: sampleFormat = AL_FORMAT_STEREO16; break;
-			case 4: sampleFormat = alGetEnumValue("AL_FORMAT_QUAD16"); break;
-			case 6: sampleFormat = alGetEnumValue("AL_FORMAT_51CHN16"); break;
-			case 7: sampleFormat = alGetEnumValue("AL_FORMAT_71CHN16"); break;
-			default: break;
-			}
-			if (sampleFormat == -1U)
-			{
-				sampleFormat = 0;
-			}
-			// copy the sample rate
-			sampleRate = fmt.nSamplesPerSec;
+			jobs.wait(handles[i]);
 		}
-		else if (std::equal(header.chunkId, header.chunkId+4, "data"))
+		catch (...)
 		{
-			// data of size header.chunkSize
-			std::vector<char> samples(header.chunkSize);
-			if (!file.read(samples.data(), samples.size()))
+			if (!error)
 			{
-				std::cerr << "cannot read the samples.\n";
-				return 0;
+				error = std::current_exception();
 			}
-			unsigned buffer;
-			alCheck(alGenBuffers(1, &buffer));
-			alBufferData(buffer, sampleFormat,
-			             samples.data(), samples.size(),
-			             sampleRate);
-			if (alGetError())
-			{
-				std::cerr << "cannot upload the samples.\n";
-				alDeleteBuffers(1, &buffer);
-				return 0;
-			}
-			return buffer;
 		}
-		else
+		if (error)
 		{
-                        // skip the other chunks
-			file.seekg(header.chunkSize, std::ios::cur);
+			continue;
+		}
+
+		const auto &[id, path] = sounds[i];
+		std::array<unsigned, VARIANT_COUNT> buffers;
+		bool loaded = parsed[i] && uploadWav(waves[i], buffers);
+		if (!addSound(id, loaded ? buffers : std::span<const unsigned>(), path))
+		{
+			success = false;
 		}
 	}
-	return 0;
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+	return success;
 }
 
 bool
-AudioDevice::load(SoundID id, const std::filesystem::path &path)
+AudioDevice::addSound(SoundID id, std::span<const unsigned> buffers,
+                      const std::filesystem::path &path)
 {
-	unsigned alBuffer = loadWav(path);
-	if (!alBuffer)
+	if (buffers.empty())
 	{
 		std::cerr << "AudioDevice::load() - failed to load \""
 		          << path << "\".\n";
 		return false;
 	}
 
-	auto [it, added] = mBuffers.insert(std::make_pair(id, alBuffer));
+	Sound sound{{}, 0, DefaultMaxInstances, DefaultMinInterval};
+	std::copy(buffers.begin(), buffers.end(), sound.buffers.begin());
+	auto [it, added] = mSounds.insert(std::make_pair(id, sound));
 	if (!added)
 	{
 		std::cerr << "AudioDevice::load() - failed to add \""
 		          << path << "\".\n";
+		alCheck(alDeleteBuffers(buffers.size(), buffers.data()));
 		return false;
 	}
 
 	return true;
 }
+
+void
+AudioDevice::setPriority(SoundID id, int priority)
+{
+	auto found = mSounds.find(id);
+	if (found == mSounds.end())
+	{
+		std::cerr << "AudioDevice::setPriority(" << static_cast<int>(id)
+		          << ") - sound id not found\n";
+		return;
+	}
+	found->second.priority = priority;
+}
+
+void
+AudioDevice::setLimits(SoundID id, unsigned maxInstances, float minInterval)
+{
+	auto found = mSounds.find(id);
+	if (found == mSounds.end())
+	{
+		std::cerr << "AudioDevice::setLimits(" << static_cast<int>(id)
+		          << ") - sound id not found\n";
+		return;
+	}
+	found->second.maxInstances = maxInstances;
+	found->second.minInterval = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<float>(minInterval));
+}
+
+void
+AudioDevice::playMusic(const std::filesystem::path &path, bool loop)
+{
+	push(PlayMusicCommand{path, loop});
+}
+
+void
+AudioDevice::stopMusic()
+{
+	push(StopMusicCommand{});
+}
@@ -1,15 +1,36 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 #include <al.h>
 #include <alc.h>
+#include <alext.h>
 
+#include <glm/glm.hpp>
+
+#include "jobsystem.hpp"
+#include "mpscqueue.hpp"
+#include "musicstream.hpp"
 #include "resources.hpp"
 
+/**
+ * All the OpenAL work happens on an audio thread started by open(),
+ * play(), stopAll(), setMasterVolume() and the music methods only
+ * queue commands for it and can be called from any thread.
+ *
+ * load() and setPriority() must be called from the thread that
+ * opened the device while no other thread is playing sounds.
+ */
 class AudioDevice
 {
 public:
@@ -19,21 +40,211 @@ public:
 	static std::vector<std::string> enumerate();
 
 	bool open(const std::string &name);
+
+	/**
+	 * Open an offline device that mixes into memory at the given
+	 * sample rate, without sound hardware and without the audio
+	 * thread: the caller drives the mixing with render().
+	 */
+	bool openLoopback(unsigned sampleRate);
 	void close();
 
+	bool isLoopback() const;
+	unsigned getSampleRate() const;
+
+	/**
+	 * Run the queued commands and mix @frames stereo frames of the
+	 * loopback device.
+	 *
+	 * @return the interleaved samples, valid until the next call.
+	 */
+	std::span<const float> render(unsigned frames);
+
 	float getMasterVolume() const;
 	void setMasterVolume(float value);
 
+	/**
+	 * Play one of the variants of the sound, picked at random, on
+	 * a free voice. When all the voices are busy steal the one with
+	 * the lowest priority, then the quietest and then the oldest,
+	 * unless its priority is higher than the priority of the new
+	 * sound.
+	 */
 	void play(SoundID id);
-	void update();
 
+	/**
+	 * Play the sound at the @position in the world, attenuated by
+	 * its distance from the listener. Sounds out of the audible
+	 * radius are dropped before a voice is allocated.
+	 */
+	void play(SoundID id, glm::vec2 position);
+	void stopAll();
+
+	/**
+	 * Move the listener, usually to the center of the camera.
+	 */
+	void setListenerPosition(glm::vec2 position);
+
+	/**
+	 * Load the sound and prepare a few variants of it, each with
+	 * its own pitch, gain and filtering, to vary its plays.
+	 */
 	bool load(SoundID id, const std::filesystem::path &path);
 
+	/**
+	 * Load many sounds parsing the files in parallel on the @jobs.
+	 * When a parse throws, the sounds after it are not loaded and
+	 * the exception is rethrown once all the parses are done.
+	 *
+	 * @retval true all the sounds have been loaded.
+	 * @retval false at least one sound failed to load.
+	 */
+	bool loadAll(JobSystem &jobs,
+	             const std::vector<std::pair<SoundID, std::filesystem::path>> &sounds);
+
+	/**
+	 * Set the priority of a loaded sound, the higher the value
+	 * the harder is for other sounds to steal its voice.
+	 */
+	void setPriority(SoundID id, int priority);
+
+	/**
+	 * Throttle a loaded sound: at most @maxInstances play at the
+	 * same time (0 means no limit) and a new instance doesn't start
+	 * before @minInterval seconds from the previous one.
+	 *
+	 * The plays of the same sound that reach the audio thread in
+	 * the same iteration, about 5 ms or one render() of a loopback
+	 * device, are merged into a single louder instance. The plays
+	 * of a frame split across two iterations are not merged, the
+	 * second one is subject to @minInterval instead.
+	 */
+	void setLimits(SoundID id, unsigned maxInstances, float minInterval);
+
+	/**
+	 * Stream the Ogg Vorbis track at @path replacing the music
+	 * being played, if any.
+	 */
+	void playMusic(const std::filesystem::path &path, bool loop=true);
+	void stopMusic();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static constexpr unsigned VARIANT_COUNT = 4;
+
+	struct Sound
+	{
+		std::array<unsigned, VARIANT_COUNT> buffers;
+		int priority;
+		unsigned maxInstances;
+		Clock::duration minInterval;
+	};
+
+	struct Voice
+	{
+		unsigned source;
+		SoundID sound;
+		int priority;
+		float gain;
+		std::uint64_t started;
+		bool playing;
+	};
+
+	struct PlayCommand
+	{
+		SoundID id;
+		Sound sound;
+		unsigned variant;
+		bool positional;
+		glm::vec2 position;
+	};
+
+	struct ListenerCommand
+	{
+		glm::vec2 position;
+	};
+
+	struct StopAllCommand
+	{
+	};
+
+	struct VolumeCommand
+	{
+		float volume;
+	};
+
+	struct PlayMusicCommand
+	{
+		std::filesystem::path path;
+		bool loop;
+	};
+
+	struct StopMusicCommand
+	{
+	};
+
+	typedef std::variant<
+		PlayCommand,
+		StopAllCommand,
+		VolumeCommand,
+		ListenerCommand,
+		PlayMusicCommand,
+		StopMusicCommand
+		> Command;
+
+private:
+	bool initialize(ALCdevice *device, ALCcontext *context, const std::string &name);
+	bool addSound(SoundID id, std::span<const unsigned> buffers,
+	              const std::filesystem::path &path);
+
+	void push(Command &&command);
+	void run();
+	void process();
+	void execute(const PlayCommand &command);
+	void execute(const StopAllCommand &command);
+	void execute(const VolumeCommand &command);
+	void execute(const ListenerCommand &command);
+	void execute(const PlayMusicCommand &command);
+	void execute(const StopMusicCommand &command);
+	float getDistance(const PlayCommand &command) const;
+	void startPending();
+	void updateVoices();
+
+	unsigned findVoice(int priority);
+	void stopVoice(unsigned index);
+	void releaseVoices();
+
+private:
+	static constexpr std::size_t COMMAND_QUEUE_SIZE = 256;
+
 private:
 	ALCdevice *mAudioDevice;
 	ALCcontext *mAudioContext;
+	unsigned mSampleRate;
 	float mMasterVolume;
-	std::vector<unsigned> mStoppedSources;
-	std::vector<unsigned> mPlayingSources;
-	std::unordered_map<SoundID, unsigned> mBuffers;
+	std::vector<Voice> mVoices;
+	std::vector<unsigned> mFreeVoices;
+	std::uint64_t mPlayCount;
+	std::unordered_map<SoundID, Sound> mSounds;
+	MusicStream mMusic;
+
+	// loopback
+	LPALCRENDERSAMPLESSOFT mRenderSamples;
+	std::vector<float> mRenderBuffer;
+
+	// audio thread
+	struct Throttle
+	{
+		PlayCommand command;
+		unsigned pending;
+		unsigned instances;
+		Clock::time_point lastStart;
+	};
+	std::unordered_map<SoundID, Throttle> mThrottles;
+	std::vector<SoundID> mPending;
+	glm::vec2 mListenerPosition;
+	MPSCQueue<Command, COMMAND_QUEUE_SIZE> mCommands;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
 };
@@ -30,6 +30,12 @@ Camera::setPosition(glm::vec2 position)
 	mInverseNeedsUpdate = true;
 }
 
+glm::vec2
+Camera::getCenter() const
+{
+	return getPosition() + mSize * 0.5f;
+}
+
 const FloatRect&
 Camera::getWorldRectangle() const
 {
@@ -15,6 +15,8 @@ public:
 	glm::vec2 getPosition() const;
 	void setPosition(glm::vec2 position);
 
+	glm::vec2 getCenter() const;
+
 	glm::vec2 getSize() const;
 	void setSize(glm::vec2 size);
 
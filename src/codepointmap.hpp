@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * Map from codepoints to values, tiered on the frequency of use:
+ * the codepoints below 256 are stored in a dense array, the rest
+ * of the Basic Multilingual Plane in pages of 256 allocated on
+ * demand and only the astral codepoints fall back to a hash map.
+ *
+ * The values never move once inserted.
+ */
+template <typename T>
+class CodepointMap
+{
+public:
+	CodepointMap();
+
+	T* find(char32_t codepoint);
+	const T* find(char32_t codepoint) const;
+
+	T& insert(char32_t codepoint, const T &value);
+
+	void clear();
+	std::size_t size() const;
+
+	/**
+	 * Call @fn(codepoint, value) for every value in the map.
+	 */
+	template <typename Function>
+	void forEach(Function fn);
+
+	template <typename Function>
+	void forEach(Function fn) const;
+
+private:
+	static constexpr unsigned PAGE_BITS = 8;
+	static constexpr char32_t PAGE_SIZE = 1U << PAGE_BITS;
+	static constexpr char32_t PAGE_MASK = PAGE_SIZE - 1;
+	static constexpr char32_t BMP_END = 0x10000;
+
+	struct Page
+	{
+		std::array<T, PAGE_SIZE> values;
+		std::bitset<PAGE_SIZE> present;
+	};
+
+private:
+	Page mDense;
+	std::array<std::unique_ptr<Page>, BMP_END / PAGE_SIZE> mPages;
+	std::unordered_map<char32_t, T> mAstral;
+	std::size_t mSize;
+};
+
+template <typename T>
+CodepointMap<T>::CodepointMap()
+	: mDense()
+	, mPages()
+	, mAstral()
+	, mSize(0)
+{
+}
+
+template <typename T>
+T*
+CodepointMap<T>::find(char32_t codepoint)
+{
+	return const_cast<T*>(
+		static_cast<const CodepointMap&>(*this).find(codepoint));
+}
+
+template <typename T>
+const T*
+CodepointMap<T>::find(char32_t codepoint) const
+{
+	if (codepoint < PAGE_SIZE)
+	{
+		return mDense.present[codepoint] ? &mDense.values[codepoint] : nullptr;
+	}
+	if (codepoint < BMP_END)
+	{
+		const auto &page = mPages[codepoint >> PAGE_BITS];
+		if (page && page->present[codepoint & PAGE_MASK])
+		{
+			return &page->values[codepoint & PAGE_MASK];
+		}
+		return nullptr;
+	}
+	auto found = mAstral.find(codepoint);
+	return found != mAstral.end() ? &found->second : nullptr;
+}
+
+template <typename T>
+T&
+CodepointMap<T>::insert(char32_t codepoint, const T &value)
+{
+	assert(!find(codepoint) && "Codepoint already present");
+
+	mSize++;
+	if (codepoint < BMP_END)
+	{
+		Page *page = &mDense;
+		if (codepoint >= PAGE_SIZE)
+		{
+			auto &ptr = mPages[codepoint >> PAGE_BITS];
+			if (!ptr)
+			{
+				ptr = std::make_unique<Page>();
+			}
+			page = ptr.get();
+		}
+		page->present.set(codepoint & PAGE_MASK);
+		return page->values[codepoint & PAGE_MASK] = value;
+	}
+	return mAstral.insert(std::make_pair(codepoint, value)).first->second;
+}
+
+template <typename T>
+void
+CodepointMap<T>::clear()
+{
+	mDense.present.reset();
+	for (auto &page : mPages)
+	{
+		page.reset();
+	}
+	mAstral.clear();
+	mSize = 0;
+}
+
+template <typename T>
+std::size_t
+CodepointMap<T>::size() const
+{
+	return mSize;
+}
+
+template <typename T>
+template <typename Function>
+void
+CodepointMap<T>::forEach(Function fn)
+{
+	const_cast<const CodepointMap&>(*this).forEach(
+		[&fn](char32_t codepoint, const T &value) {
+			fn(codepoint, const_cast<T&>(value));
+		});
+}
+
+template <typename T>
+template <typename Function>
+void
+CodepointMap<T>::forEach(Function fn) const
+{
+	for (char32_t i = 0; i < PAGE_SIZE; ++i)
+	{
+		if (mDense.present[i])
+		{
+			fn(i, mDense.values[i]);
+		}
+	}
+	for (char32_t base = PAGE_SIZE; base < BMP_END; base += PAGE_SIZE)
+	{
+		const auto &page = mPages[base >> PAGE_BITS];
+		for (char32_t i = 0; page && i < PAGE_SIZE; ++i)
+		{
+			if (page->present[i])
+			{
+				fn(base + i, page->values[i]);
+			}
+		}
+	}
+	for (const auto &[codepoint, value] : mAstral)
+	{
+		fn(codepoint, value);
+	}
+}
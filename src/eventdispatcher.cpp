@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cassert>
+
+#include "eventdispatcher.hpp"
+
+EventDispatcher::EventDispatcher()
+	: mListeners()
+	, mPriorities()
+	, mDispatching(false)
+{
+}
+
+void
+EventDispatcher::unsubscribe(const void *owner)
+{
+	assert(!mDispatching && "Unsubscribe while dispatching");
+	for (auto &listeners : mListeners)
+	{
+		std::erase_if(listeners, [owner](const Listener &listener) {
+			return listener.owner == owner;
+		});
+	}
+	mPriorities.erase(owner);
+}
+
+void
+EventDispatcher::setPriority(const void *owner, int priority)
+{
+	assert(!mDispatching && "Set the priority while dispatching");
+	mPriorities[owner] = priority;
+	for (auto &listeners : mListeners)
+	{
+		bool changed = false;
+		for (auto &listener : listeners)
+		{
+			if (listener.owner == owner && listener.priority != priority)
+			{
+				listener.priority = priority;
+				changed = true;
+			}
+		}
+		if (changed)
+		{
+			std::stable_sort(
+				listeners.begin(), listeners.end(),
+				[](const Listener &a, const Listener &b) {
+					return a.priority < b.priority;
+				});
+		}
+	}
+}
+
+void
+EventDispatcher::insert(std::vector<Listener> &listeners, Listener &&listener)
+{
+	// after the listeners with the same priority
+	auto pos = std::upper_bound(
+		listeners.begin(), listeners.end(), listener.priority,
+		[](int priority, const Listener &other) {
+			return priority < other.priority;
+		});
+	listeners.insert(pos, std::move(listener));
+}
+
+bool
+EventDispatcher::dispatch(const Event &event)
+{
+	const auto &listeners = mListeners[event.index()];
+	mDispatching = true;
+	bool handled = false;
+	for (auto it = listeners.rbegin(), end = listeners.rend();
+	     it != end && !handled;
+	     ++it)
+	{
+		handled = it->callback(event);
+	}
+	mDispatching = false;
+	return handled;
+}
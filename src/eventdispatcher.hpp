@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "event.hpp"
+
+/**
+ * Registry of the listeners of each alternative of Event: dispatch()
+ * indexes the listeners of the event with Event::index(), so whoever
+ * isn't subscribed to an event type costs nothing.
+ *
+ * The listeners of a type are called from the highest priority of
+ * their owner to the lowest and, within the same priority, from the
+ * last subscribed to the first, until one of them returns true.
+ * ViewStack gives every view the priority of its position in the
+ * stack, so the views on top see the events first.
+ *
+ * The listeners can't subscribe or unsubscribe while dispatching.
+ */
+class EventDispatcher
+{
+public:
+	EventDispatcher();
+
+	/**
+	 * Call @listener for the events of type T until @owner
+	 * unsubscribes.
+	 */
+	template <typename T>
+	void subscribe(const void *owner, std::function<bool(const T&)> listener);
+
+	/**
+	 * Remove all the listeners of @owner.
+	 */
+	void unsubscribe(const void *owner);
+
+	/**
+	 * Set the priority of all the listeners of @owner, present
+	 * and future, zero by default.
+	 */
+	void setPriority(const void *owner, int priority);
+
+	/**
+	 * @retval true the event has been handled by a listener.
+	 * @retval false no listener handled the event.
+	 */
+	bool dispatch(const Event &event);
+
+private:
+	struct Listener
+	{
+		const void *owner;
+		int priority;
+		std::function<bool(const Event&)> callback;
+	};
+
+	template <typename T>
+	static constexpr std::size_t indexOf();
+
+	void insert(std::vector<Listener> &listeners, Listener &&listener);
+
+private:
+	// sorted by increasing priority, then by subscription
+	std::array<std::vector<Listener>, std::variant_size_v<Event>> mListeners;
+	std::unordered_map<const void*, int> mPriorities;
+	bool mDispatching;
+};
+
+template <typename T>
+constexpr std::size_t
+EventDispatcher::indexOf()
+{
+	return []<std::size_t... I>(std::index_sequence<I...>) {
+		std::size_t index = sizeof...(I);
+		((std::is_same_v<T, std::variant_alternative_t<I, Event>>
+		  && (index = I, true)) || ...);
+		return index;
+	}(std::make_index_sequence<std::variant_size_v<Event>>());
+}
+
+template <typename T>
+void
+EventDispatcher::subscribe(const void *owner, std::function<bool(const T&)> listener)
+{
+	constexpr std::size_t index = indexOf<T>();
+	static_assert(index < std::variant_size_v<Event>, "Not an Event type");
+
+	assert(!mDispatching && "Subscribe while dispatching");
+	auto found = mPriorities.find(owner);
+	insert(mListeners[index], {
+		owner,
+		found != mPriorities.end() ? found->second : 0,
+		[listener = std::move(listener)](const Event &event) {
+			return listener(*std::get_if<T>(&event));
+		},
+	});
+}
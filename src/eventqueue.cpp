@@ -1,16 +1,59 @@
 #include <cassert>
-#include <iostream>
 
 #include <GLFW/glfw3.h>
 
 #include "eventqueue.hpp"
 #include "window.hpp"
 
+namespace
+{
+template <typename T>
+bool
+replaceEvent(Event &last, const Event &event)
+{
+	auto l = std::get_if<T>(&last);
+	auto e = std::get_if<T>(&event);
+	if (!l || !e || l->window != e->window)
+	{
+		return false;
+	}
+	*l = *e;
+	return true;
+}
+
+bool
+accumulateScroll(Event &last, const Event &event)
+{
+	auto l = std::get_if<MouseScrolled>(&last);
+	auto e = std::get_if<MouseScrolled>(&event);
+	if (!l || !e || l->window != e->window)
+	{
+		return false;
+	}
+	l->x += e->x;
+	l->y += e->y;
+	return true;
+}
+
+bool
+isCoalescable(const Event &event)
+{
+	return std::holds_alternative<MouseCursorMoved>(event)
+		|| std::holds_alternative<MouseScrolled>(event)
+		|| std::holds_alternative<WindowMoved>(event)
+		|| std::holds_alternative<WindowResized>(event)
+		|| std::holds_alternative<FramebufferResized>(event);
+}
+}
+
 EventQueue::EventQueue()
 	: mWindows()
 	, mEvents()
 	, mRead(0)
 	, mWrite(0)
+	, mStaged()
+	, mStagedRead(0)
+	, mCoalescing(true)
 {
 }
 
@@ -40,24 +83,36 @@ void
 EventQueue::poll()
 {
 	glfwPollEvents();
+	flush();
 }
 
 bool
 EventQueue::empty() const
 {
-	return mRead == mWrite;
+	return mRead.load(std::memory_order_relaxed)
+		== mWrite.load(std::memory_order_acquire);
 }
 
 bool
 EventQueue::pop(Event &event)
 {
-	if (mRead == mWrite)
+	double time;
+	return pop(event, time);
+}
+
+bool
+EventQueue::pop(Event &event, double &time)
+{
+	unsigned read = mRead.load(std::memory_order_relaxed);
+	if (read == mWrite.load(std::memory_order_acquire))
 	{
 		return false;
 	}
 
-	event = mEvents[mRead & (QUEUE_SIZE - 1)];
-	++mRead;
+	const auto &entry = mEvents[read & (QUEUE_SIZE - 1)];
+	event = entry.event;
+	time = entry.time;
+	mRead.store(read + 1, std::memory_order_release);
 	return true;
 }
 
@@ -89,17 +144,75 @@ EventQueue::track(Window &window)
 	glfwSetCharCallback(wptr, charCallback);
 }
 
+void
+EventQueue::setCoalescing(bool enabled)
+{
+	mCoalescing = enabled;
+}
+
+bool
+EventQueue::coalesce(const Event &event)
+{
+	// only the staged events are out of reach of the consumer
+	if (mStagedRead == mStaged.size())
+	{
+		return false;
+	}
+	auto &last = mStaged.back().event;
+	return replaceEvent<MouseCursorMoved>(last, event)
+		|| accumulateScroll(last, event)
+		|| replaceEvent<WindowMoved>(last, event)
+		|| replaceEvent<WindowResized>(last, event)
+		|| replaceEvent<FramebufferResized>(last, event);
+}
+
 void
 EventQueue::add(Event &&event)
 {
-	if (mRead + QUEUE_SIZE == mWrite)
+	if (mCoalescing && coalesce(event))
+	{
+		return;
+	}
+
+	// keep the order behind the staged events, hold back the
+	// coalescable ones until the end of poll()
+	flush();
+	unsigned write = mWrite.load(std::memory_order_relaxed);
+	if (mStagedRead != mStaged.size()
+	    || (mCoalescing && isCoalescable(event))
+	    || write - mRead.load(std::memory_order_acquire) == QUEUE_SIZE)
 	{
-		std::cerr << "EventQueue::add() failed - queue full, event lost\n";
+		mStaged.push_back({std::move(event), glfwGetTime()});
 		return;
 	}
 
-	mEvents[mWrite & (QUEUE_SIZE - 1)] = std::move(event);
-	++mWrite;
+	mEvents[write & (QUEUE_SIZE - 1)] = {std::move(event), glfwGetTime()};
+	mWrite.store(write + 1, std::memory_order_release);
+}
+
+void
+EventQueue::flush()
+{
+	if (mStagedRead == mStaged.size())
+	{
+		return;
+	}
+
+	unsigned write = mWrite.load(std::memory_order_relaxed);
+	unsigned read = mRead.load(std::memory_order_acquire);
+	while (write - read < QUEUE_SIZE && mStagedRead != mStaged.size())
+	{
+		mEvents[write & (QUEUE_SIZE - 1)] = std::move(mStaged[mStagedRead++]);
+		++write;
+	}
+	mWrite.store(write, std::memory_order_release);
+
+	// keep the capacity for the next burst
+	if (mStagedRead == mStaged.size())
+	{
+		mStaged.clear();
+		mStagedRead = 0;
+	}
 }
 
 EventQueue&
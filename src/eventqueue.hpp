@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <unordered_map>
+#include <vector>
 
 #include "event.hpp"
 
@@ -8,20 +10,48 @@ struct GLFWwindow;
 
 class Window;
 
+/**
+ * Lock-free single-producer/single-consumer queue of events: the
+ * thread polling GLFW produces the events and another thread can
+ * consume them with pop() without blocking.
+ *
+ * When the ring is full the events are staged in a buffer owned by
+ * the producer and moved to the ring as soon as there is room again,
+ * so that no event is lost.
+ *
+ * With coalescing enabled consecutive cursor, scroll, window move
+ * and resize events of the same window are merged while still staged,
+ * keeping the latest position or size and the sum of the scrolls.
+ *
+ * Every event is stamped with the time of its GLFW callback, a
+ * coalesced event keeps the time of the first event merged.
+ */
 class EventQueue
 {
 public:
 	EventQueue();
 	~EventQueue();
 
+	/**
+	 * Poll the GLFW events, producer side.
+	 */
 	void poll();
+
+	/**
+	 * Consumer side.
+	 */
 	bool empty() const;
 	bool pop(Event &event);
+	bool pop(Event &event, double &time);
 
 	void track(Window &window);
 
+	void setCoalescing(bool enabled);
+
 private:
 	void add(Event &&event);
+	void flush();
+	bool coalesce(const Event &event);
 
 	static EventQueue& getEventQueue(GLFWwindow *window);
 
@@ -44,9 +74,20 @@ private:
 private:
 	static constexpr std::size_t QUEUE_SIZE = 256;
 
+	struct Entry
+	{
+		Event event;
+		double time;
+	};
+
 private:
 	std::unordered_map<GLFWwindow *, Window *> mWindows;
-	Event mEvents[QUEUE_SIZE];
-	unsigned mRead;
-	unsigned mWrite;
+	Entry mEvents[QUEUE_SIZE];
+	alignas(64) std::atomic<unsigned> mRead;
+	alignas(64) std::atomic<unsigned> mWrite;
+
+	// producer only
+	std::vector<Entry> mStaged;
+	std::size_t mStagedRead;
+	bool mCoalescing;
 };
@@ -1,17 +1,39 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
 #include "rendertarget.hpp"
 #include "font.hpp"
+#include "jobsystem.hpp"
 #include "utility.hpp"
 
 namespace
 {
-const int TEXTURE_WIDTH = 1024;
-const int TEXTURE_HEIGHT = 1024;
+const unsigned TEXTURE_WIDTH = 1024;
+const unsigned TEXTURE_HEIGHT = 1024;
+const unsigned PAGE_INITIAL_SIZE = 128;
 const int PADDING = 2;
 
+const char CACHE_MAGIC[4] = { 'R', 'R', 'F', 'C' };
+const std::uint32_t CACHE_VERSION = 2;
+
+// distance in pixels covered by the signed distance field
+const FT_Int SDF_SPREAD = 8;
+
+// don't wake up a worker for less glyphs than this
+const std::size_t GLYPHS_PER_WORKER = 16;
+
+std::filesystem::path cacheDirectory;
+JobSystem *jobSystem = nullptr;
+
+// codepoints of the text measured, reused by every call
+thread_local std::vector<char32_t> codepointBuffer;
+
 static inline unsigned
 roundUp2(unsigned v)
 {
@@ -23,58 +45,313 @@ roundUp2(unsigned v)
 	v |= v >> 16;
 	return v + 1;
 }
+
+// 64-bit FNV-1a
+std::uint64_t
+hash(std::string_view data, std::uint64_t h = 0xcbf29ce484222325ULL)
+{
+	for (unsigned char c : data)
+	{
+		h ^= c;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+template <typename T>
+void
+write(std::ostream &out, const T &value)
+{
+	out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+bool
+read(std::istream &in, T &value)
+{
+	return static_cast<bool>(
+		in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
 }
 
 Font::Font()
 	: mFT(nullptr)
 	, mFace(nullptr)
 	, mLineHeight(0.f)
-	, mPositionX(0)
-	, mPositionY(0)
-	, mMaxHeight(0)
+	, mPixelSize(0)
+	, mMode(Mode::Bitmap)
 {
 }
 
 Font::~Font()
 {
-	FT_Done_Face(mFace);
-	FT_Done_FreeType(mFT);
+	closeFaces();
+}
+
+void
+Font::setCacheDirectory(const std::filesystem::path &directory)
+{
+	cacheDirectory = directory;
+}
+
+void
+Font::setJobSystem(JobSystem *jobs)
+{
+	jobSystem = jobs;
 }
 
 bool
-Font::loadFromFile(const std::filesystem::path &path, unsigned size)
+Font::loadFromFile(const std::filesystem::path &path, unsigned size,
+                   const std::string &charset, Mode mode)
 {
-	FT_Done_FreeType(mFT);
-	if (FT_Init_FreeType(&mFT))
+	closeFaces();
+
+	std::ifstream in(path, std::ios::in|std::ios::binary);
+	std::stringstream data;
+	if (!in || !(data << in.rdbuf()))
 	{
-		std::cerr << "Font::loadFromFile() - Cannot initialize the freetype2 library"
-			  << std::endl;
+		std::cerr << "Font::loadFromFile() - Failed to read the font "
+			  << path << std::endl;
 		return false;
 	}
+	mFontData = data.str();
+	mPixelSize = size;
+	mMode = mode;
 
-	FT_Done_Face(mFace);
-	if (FT_New_Face(mFT, path.c_str(), 0, &mFace))
+	if (!openFace(mFT, mFace))
 	{
 		std::cerr << "Font::loadFromFile() - Failed to load the font "
 			  << path << std::endl;
 		return false;
 	}
-	FT_Set_Pixel_Sizes(mFace, 0, size);
 
 	mLineHeight = (mFace->size->metrics.ascender-mFace->size->metrics.descender)  / 64.f;
 	mGlyphs.clear();
-	mPositionX = mPositionY = mMaxHeight = 0;
+	for (auto &page : mPages)
+	{
+		page.texture.destroy();
+	}
+	mPages.clear();
+
+	if (charset.empty())
+	{
+		return true;
+	}
+
+	std::uint64_t fontHash = 0;
+	std::filesystem::path cachePath;
+	std::uint64_t charsetHash = hash(charset);
+	if (!cacheDirectory.empty())
+	{
+		fontHash = hash(mFontData);
+		std::stringstream name;
+		name << std::hex << fontHash << "-" << charsetHash
+		     << "-" << std::dec << size
+		     << (mode == Mode::DistanceField ? "-sdf" : "") << ".atlas";
+		cachePath = cacheDirectory / name.str();
+		if (loadCache(cachePath, fontHash, charsetHash))
+		{
+			return true;
+		}
+	}
 
+	// rasterize the glyphs and save the atlas for the next run
+	prefetch(charset);
+	if (!cachePath.empty())
+	{
+		saveCache(cachePath, fontHash, charsetHash);
+	}
 	return true;
 }
 
+bool
+Font::openFace(FT_Library &library, FT_Face &face) const
+{
+	if (FT_Init_FreeType(&library))
+	{
+		std::cerr << "Font::openFace() - Cannot initialize the freetype2 library"
+			  << std::endl;
+		library = nullptr;
+		return false;
+	}
+	if (mMode == Mode::DistanceField)
+	{
+		FT_Property_Set(library, "sdf", "spread", &SDF_SPREAD);
+		FT_Property_Set(library, "bsdf", "spread", &SDF_SPREAD);
+	}
+
+	auto data = reinterpret_cast<const FT_Byte *>(mFontData.data());
+	if (FT_New_Memory_Face(library, data, mFontData.size(), 0, &face))
+	{
+		FT_Done_FreeType(library);
+		library = nullptr;
+		face = nullptr;
+		return false;
+	}
+	FT_Set_Pixel_Sizes(face, 0, mPixelSize);
+	return true;
+}
+
+void
+Font::closeFaces()
+{
+	// NOTE: the faces belong to the libraries, release them first
+	for (auto &rasterizer : mRasterizers)
+	{
+		FT_Done_Face(rasterizer.face);
+		FT_Done_FreeType(rasterizer.library);
+	}
+	mRasterizers.clear();
+	FT_Done_Face(mFace);
+	FT_Done_FreeType(mFT);
+	mFace = nullptr;
+	mFT = nullptr;
+}
+
+bool
+Font::loadCache(const std::filesystem::path &path,
+                std::uint64_t fontHash, std::uint64_t charsetHash)
+{
+	std::ifstream in(path, std::ios::in|std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+
+	char magic[4];
+	std::uint32_t version, pixelSize, mode, pageCount, glyphCount;
+	std::uint64_t cachedFontHash, cachedCharsetHash;
+	if (!read(in, magic)
+	    || !std::equal(magic, magic + 4, CACHE_MAGIC)
+	    || !read(in, version) || version != CACHE_VERSION
+	    || !read(in, cachedFontHash) || cachedFontHash != fontHash
+	    || !read(in, pixelSize) || pixelSize != mPixelSize
+	    || !read(in, mode) || mode != static_cast<std::uint32_t>(mMode)
+	    || !read(in, cachedCharsetHash) || cachedCharsetHash != charsetHash
+	    || !read(in, pageCount))
+	{
+		return false;
+	}
+
+	struct CachedPage
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::vector<SkylinePacker::Node> skyline;
+		std::vector<std::uint8_t> pixels;
+	};
+	std::vector<CachedPage> pages;
+	for (std::uint32_t i = 0; i < pageCount; ++i)
+	{
+		auto &page = pages.emplace_back();
+		std::uint32_t nodeCount;
+		if (!read(in, page.width) || !read(in, page.height)
+		    || page.width == 0 || page.width > TEXTURE_WIDTH
+		    || page.height == 0 || page.height > TEXTURE_HEIGHT
+		    || !read(in, nodeCount) || nodeCount > page.width)
+		{
+			return false;
+		}
+
+		page.skyline.resize(nodeCount);
+		page.pixels.resize(page.width * page.height);
+		if (!in.read(reinterpret_cast<char *>(page.skyline.data()),
+		             page.skyline.size() * sizeof(page.skyline[0]))
+		    || !in.read(reinterpret_cast<char *>(page.pixels.data()),
+		                page.pixels.size())
+		    || !SkylinePacker::isValid(page.width, page.height, page.skyline))
+		{
+			return false;
+		}
+	}
+
+	CodepointMap<Glyph> glyphs;
+	if (!read(in, glyphCount))
+	{
+		return false;
+	}
+	for (std::uint32_t i = 0; i < glyphCount; ++i)
+	{
+		char32_t codepoint;
+		Glyph glyph;
+		if (!read(in, codepoint) || !read(in, glyph)
+		    || glyph.page >= pageCount || glyphs.find(codepoint))
+		{
+			return false;
+		}
+		glyphs.insert(codepoint, glyph);
+	}
+
+	// everything is valid, upload each page at once
+	for (auto &cached : pages)
+	{
+		auto &page = mPages.emplace_back();
+		page.packer.setSkyline(cached.width, cached.height, std::move(cached.skyline));
+		page.texture.create(cached.width, cached.height, cached.pixels.data(),
+		                    false, true, Texture::Format::Alpha);
+	}
+	mGlyphs = std::move(glyphs);
+	return true;
+}
+
+void
+Font::saveCache(const std::filesystem::path &path,
+                std::uint64_t fontHash, std::uint64_t charsetHash) const
+{
+	std::error_code ec;
+	std::filesystem::create_directories(path.parent_path(), ec);
+	std::ofstream out(path, std::ios::out|std::ios::binary|std::ios::trunc);
+	if (!out)
+	{
+		std::cerr << "Font::saveCache() - cannot write " << path << "\n";
+		return;
+	}
+
+	out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	write(out, CACHE_VERSION);
+	write(out, fontHash);
+	write(out, static_cast<std::uint32_t>(mPixelSize));
+	write(out, static_cast<std::uint32_t>(mMode));
+	write(out, charsetHash);
+	write(out, static_cast<std::uint32_t>(mPages.size()));
+
+	// NOTE: the atlas lives only on the GPU, read it back
+	std::vector<std::uint8_t> pixels;
+	for (const auto &page : mPages)
+	{
+		page.texture.getPixels(pixels);
+		const auto &skyline = page.packer.getSkyline();
+		write(out, static_cast<std::uint32_t>(page.texture.getWidth()));
+		write(out, static_cast<std::uint32_t>(page.texture.getHeight()));
+		write(out, static_cast<std::uint32_t>(skyline.size()));
+		out.write(reinterpret_cast<const char *>(skyline.data()),
+		          skyline.size() * sizeof(skyline[0]));
+		out.write(reinterpret_cast<const char *>(pixels.data()),
+		          pixels.size());
+	}
+
+	write(out, static_cast<std::uint32_t>(mGlyphs.size()));
+	mGlyphs.forEach([&out](char32_t codepoint, const Glyph &glyph) {
+		write(out, codepoint);
+		write(out, glyph);
+	});
+
+	if (!out)
+	{
+		std::cerr << "Font::saveCache() - failed to write " << path << "\n";
+		out.close();
+		std::filesystem::remove(path, ec);
+	}
+}
+
 glm::vec2
-Font::getSize(const std::string &text) const
+Font::getSize(const std::string &text, unsigned characterSize) const
 {
 	float width = 0;
 	float height = 0;
-	auto codepoints = Utility::decodeUTF8(text);
-	for (auto codepoint: codepoints)
+	codepointBuffer.resize(std::max(codepointBuffer.size(), text.size()));
+	auto count = Utility::decodeUTF8(text, codepointBuffer);
+	for (auto codepoint : std::span(codepointBuffer).first(count))
 	{
 		const auto &glyph = getGlyph(codepoint);
 		if (height < glyph.size.y + glyph.bearing.y)
@@ -83,154 +360,319 @@ Font::getSize(const std::string &text) const
 		}
 		width += glyph.advance;
 	}
-	return { width, height };
+	return glm::vec2(width, height) * getScale(characterSize);
+}
+
+float
+Font::getLineHeight(unsigned characterSize) const
+{
+	return mLineHeight * getScale(characterSize);
 }
 
 float
-Font::getLineHeight() const
+Font::getScale(unsigned characterSize) const
 {
-	return mLineHeight;
+	if (characterSize == 0 || mPixelSize == 0)
+	{
+		return 1.f;
+	}
+	return static_cast<float>(characterSize) / mPixelSize;
+}
+
+Font::Mode
+Font::getMode() const
+{
+	return mMode;
 }
 
 const Texture&
-Font::getTexture() const
+Font::getTexture(unsigned page) const
 {
-	return mTexture;
+	assert(page < mPages.size() && "Page not found");
+	return mPages[page].texture;
+}
+
+unsigned
+Font::getPageCount() const
+{
+	return mPages.size();
+}
+
+unsigned
+Font::allocateGlyph(unsigned width, unsigned height, glm::ivec2 &pos) const
+{
+	if (width > TEXTURE_WIDTH || height > TEXTURE_HEIGHT)
+	{
+		throw std::runtime_error("Font::getGlyph() - "
+		                         "the glyph is bigger than the texture");
+	}
+
+	// try the last page, growing it up to the maximum size
+	if (!mPages.empty())
+	{
+		unsigned index = mPages.size() - 1;
+		auto &packer = mPages.back().packer;
+		for (;;)
+		{
+			if (packer.pack(width, height, pos))
+			{
+				return index;
+			}
+
+			unsigned texWidth = packer.getWidth();
+			unsigned texHeight = packer.getHeight();
+			if (texWidth <= texHeight && texWidth < TEXTURE_WIDTH)
+			{
+				texWidth *= 2;
+			}
+			else if (texHeight < TEXTURE_HEIGHT)
+			{
+				texHeight *= 2;
+			}
+			else if (texWidth < TEXTURE_WIDTH)
+			{
+				texWidth *= 2;
+			}
+			else
+			{
+				break;
+			}
+			resizeTexture(index, texWidth, texHeight);
+		}
+	}
+
+	// spill into a new page
+	unsigned size = std::min(
+		std::max(PAGE_INITIAL_SIZE, roundUp2(std::max(width, height))),
+		std::min(TEXTURE_WIDTH, TEXTURE_HEIGHT));
+	std::vector<std::uint8_t> blank(size * size, 0);
+	auto &page = mPages.emplace_back();
+	page.texture.create(size, size, blank.data(), false, true,
+	                    Texture::Format::Alpha);
+	page.packer.reset(size, size);
+	if (!page.packer.pack(width, height, pos))
+	{
+		throw std::runtime_error("Font::getGlyph() - "
+		                         "no space left in the texture");
+	}
+	return mPages.size() - 1;
 }
 
 void
-Font::resizeTexture(unsigned newWidth, unsigned newHeight) const
+Font::resizeTexture(unsigned page, unsigned newWidth, unsigned newHeight) const
 {
-	auto oldWidth = mTexture.getWidth();
-	auto oldHeight = mTexture.getHeight();
+	auto &atlas = mPages[page];
+	auto oldWidth = atlas.texture.getWidth();
+	auto oldHeight = atlas.texture.getHeight();
 
-	Texture newTexture;
-	newTexture.create(newWidth, newHeight);
-	newTexture.update(mTexture);
-	std::swap(mTexture, newTexture);
+	// copy the old atlas on the GPU, the staged glyphs keep their
+	// position; the move releases the old texture and keeps the
+	// address the render target points to
+	std::vector<std::uint8_t> blank(newWidth * newHeight, 0);
+	Texture texture;
+	texture.create(newWidth, newHeight, blank.data(), false, true,
+	               Texture::Format::Alpha);
+	texture.update(atlas.texture);
+	atlas.texture = std::move(texture);
+	atlas.packer.grow(newWidth, newHeight);
 
 	glm::vec2 scale{
 		static_cast<float>(oldWidth) / newWidth,
 		static_cast<float>(oldHeight) / newHeight
 	};
-	for (auto &[codepoint, glyph]: mGlyphs)
-	{
-		glyph.uvPos *= scale;
-		glyph.uvSize *= scale;
-	}
+	mGlyphs.forEach([page, scale](char32_t, Glyph &glyph) {
+		if (glyph.page == page)
+		{
+			glyph.uvPos *= scale;
+			glyph.uvSize *= scale;
+		}
+	});
 }
 
-const Font::Glyph&
-Font::getGlyph(char32_t codepoint) const
+bool
+Font::rasterize(FT_Face face, char32_t codepoint, Bitmap &bitmap) const
 {
-	if (const auto it = mGlyphs.find(codepoint); it != mGlyphs.end())
+	bitmap.codepoint = codepoint;
+	bitmap.valid = false;
+
+	FT_Error error;
+	if (mMode == Mode::DistanceField)
 	{
-		return it->second;
+		// NOTE: empty outlines (e.g. space) have nothing to render
+		error = FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT);
+		if (!error && face->glyph->outline.n_points > 0)
+		{
+			error = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF);
+		}
 	}
-
-	if (FT_Load_Char(mFace, codepoint, FT_LOAD_RENDER))
+	else
 	{
-		throw std::runtime_error(
-			"Font::getGlyph() - cannot load the glyph for codepoint "
-			+ std::to_string(codepoint));
+		error = FT_Load_Char(face, codepoint, FT_LOAD_RENDER);
+	}
+	if (error)
+	{
+		return false;
 	}
 
-	int bmWidth = mFace->glyph->bitmap.width + 2 * PADDING;
-	int bmHeight = mFace->glyph->bitmap.rows + 2 * PADDING;
-	if (mMaxHeight < bmHeight)
+	// copy the coverage into the padded pixel buffer
+	const auto &source = face->glyph->bitmap;
+	bitmap.width = source.width + 2 * PADDING;
+	bitmap.height = source.rows + 2 * PADDING;
+	bitmap.pixels.assign(bitmap.width * bitmap.height, 0);
+	const std::uint8_t *src = source.buffer;
+	std::uint8_t *dst = bitmap.pixels.data() + PADDING * bitmap.width + PADDING;
+	for (unsigned y = 0; y < source.rows; ++y)
 	{
-		mMaxHeight = bmHeight;
+		std::copy(src, src + source.width, dst);
+		src += source.pitch;
+		dst += bitmap.width;
 	}
 
-	auto texWidth = mTexture.getWidth();
-	auto texHeight = mTexture.getHeight();
-	bool resize = false;
-	if (unsigned right = mPositionX + bmWidth; right > texWidth)
+	bitmap.bearing = glm::vec2(face->glyph->bitmap_left,
+	                           face->glyph->bitmap_top);
+	bitmap.advance = static_cast<float>(face->glyph->advance.x) / 64.f;
+	bitmap.valid = true;
+	return true;
+}
+
+const Font::Glyph&
+Font::addGlyph(const Bitmap &bitmap) const
+{
+	glm::ivec2 position;
+	unsigned page = allocateGlyph(bitmap.width, bitmap.height, position);
+	auto &atlas = mPages[page];
+	auto texWidth = atlas.texture.getWidth();
+	auto texHeight = atlas.texture.getHeight();
+
+	// stage the glyph, padding included, the upload is deferred
+	atlas.pending.emplace_back(position, glm::ivec2(bitmap.width, bitmap.height));
+	atlas.staging.insert(atlas.staging.end(),
+	                     bitmap.pixels.begin(), bitmap.pixels.end());
+
+	unsigned width = bitmap.width - 2 * PADDING;
+	unsigned height = bitmap.height - 2 * PADDING;
+
+	Glyph glyph;
+	glyph.uvPos.x = static_cast<float>(position.x + PADDING) / texWidth;
+	glyph.uvPos.y = static_cast<float>(position.y + PADDING) / texHeight;
+	glyph.uvSize.x = static_cast<float>(width) / texWidth;
+	glyph.uvSize.y = static_cast<float>(height) / texHeight;
+
+	glyph.size = glm::vec2(width, height);
+	glyph.bearing = bitmap.bearing;
+	glyph.advance = bitmap.advance;
+	glyph.page = page;
+
+	return mGlyphs.insert(bitmap.codepoint, glyph);
+}
+
+void
+Font::uploadPages() const
+{
+	for (auto &page : mPages)
 	{
-		unsigned newTexWidth = texWidth
-			? texWidth * 2
-			: roundUp2(right);
-		if (newTexWidth <= TEXTURE_WIDTH)
-		{
-			texWidth = newTexWidth;
-			resize = true;
-		}
-		else
+		if (!page.pending.empty())
 		{
-			mPositionY += mMaxHeight;
-			mPositionX = 0;
-			mMaxHeight = 0;
+			page.texture.update(page.staging.data(), page.pending);
+			page.pending.clear();
+			page.staging.clear();
+			page.staging.shrink_to_fit();
 		}
 	}
-	if (unsigned bottom = mPositionY + bmHeight; bottom > texHeight)
+}
+
+void
+Font::prefetch(const std::string &text) const
+{
+	prefetch(Utility::decodeUTF8(text));
+}
+
+void
+Font::prefetch(std::u32string_view codepoints) const
+{
+	std::vector<char32_t> missing;
+	for (auto codepoint : codepoints)
 	{
-		unsigned newTexHeight = texHeight
-			? texHeight * 2
-			: roundUp2(bottom);
-		if (newTexHeight <= TEXTURE_HEIGHT)
-		{
-			texHeight = newTexHeight;
-			resize = true;
-		}
-		else
+		if (!mGlyphs.find(codepoint))
 		{
-			throw std::runtime_error("Font::getGlyph() - "
-						 "no space left in the texture");
+			missing.push_back(codepoint);
 		}
 	}
-	if (resize)
+	std::sort(missing.begin(), missing.end());
+	missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+	if (missing.empty())
 	{
-		resizeTexture(texWidth, texHeight);
+		return;
 	}
 
-	// clear the pixel buffer
-	mPixelBuffer.resize(bmWidth * bmHeight * 4);
-	std::uint8_t *pix = mPixelBuffer.data();
-	for (std::size_t i = 0; i < mPixelBuffer.size() / 4; ++i)
+	std::vector<Bitmap> bitmaps(missing.size());
+	std::size_t workers = std::min<std::size_t>(
+		jobSystem ? jobSystem->getWorkerCount() : 1,
+		(missing.size() + GLYPHS_PER_WORKER - 1) / GLYPHS_PER_WORKER);
+	while (mRasterizers.size() < workers)
 	{
-		*pix++ = 255;
-		*pix++ = 255;
-		*pix++ = 255;
-		*pix++ = 0;
+		Rasterizer rasterizer;
+		if (!openFace(rasterizer.library, rasterizer.face))
+		{
+			break;
+		}
+		mRasterizers.push_back(rasterizer);
 	}
+	workers = std::min(workers, mRasterizers.size());
 
-	// render the pixel
-	pix = mFace->glyph->bitmap.buffer;
-	for (int y = PADDING; y < bmHeight - PADDING; ++y)
+	if (workers <= 1)
 	{
-		for (int x = PADDING; x < bmWidth - PADDING; ++x)
+		for (std::size_t i = 0; i < missing.size(); ++i)
 		{
-			const std::size_t index = x + y * bmWidth;
-			mPixelBuffer[index * 4 + 3] = pix[x - PADDING];
+			rasterize(mFace, missing[i], bitmaps[i]);
 		}
-		pix += mFace->glyph->bitmap.pitch;
+	}
+	else
+	{
+		// FreeType faces are not thread safe, one for each range
+		std::atomic<std::size_t> next = 0;
+		jobSystem->wait(jobSystem->parallelFor(
+			workers, 1, [&](std::size_t w, std::size_t) {
+				auto face = mRasterizers[w].face;
+				for (auto i = next++; i < missing.size(); i = next++)
+				{
+					rasterize(face, missing[i], bitmaps[i]);
+				}
+			}));
 	}
 
-	// upload the data
-	mTexture.update(mPixelBuffer.data(), mPositionX, mPositionY, bmWidth, bmHeight);
-
-	bmWidth -= 2 * PADDING;
-	bmHeight -= 2 * PADDING;
-
-	Glyph glyph;
-	glyph.uvPos.x = static_cast<float>(mPositionX + PADDING) / texWidth;
-	glyph.uvPos.y = static_cast<float>(mPositionY + PADDING) / texHeight;
-	glyph.uvSize.x = static_cast<float>(bmWidth) / texWidth;
-	glyph.uvSize.y = static_cast<float>(bmHeight) / texHeight;
-
-	glyph.size = glm::vec2(bmWidth, bmHeight);
-	glyph.bearing = glm::vec2(mFace->glyph->bitmap_left,
-				  mFace->glyph->bitmap_top);
-	glyph.advance = static_cast<float>(mFace->glyph->advance.x) / 64.f;
+	// pack the tallest glyphs first, then upload every page once;
+	// the failed glyphs will throw when they are requested
+	std::sort(bitmaps.begin(), bitmaps.end(),
+	          [](const Bitmap &a, const Bitmap &b) {
+		          return a.height > b.height;
+	          });
+	for (const auto &bitmap : bitmaps)
+	{
+		if (bitmap.valid)
+		{
+			addGlyph(bitmap);
+		}
+	}
+	uploadPages();
+}
 
-	const auto [it, success] = mGlyphs.insert(std::make_pair(codepoint, std::move(glyph)));
-	if (!success)
+const Font::Glyph&
+Font::getGlyph(char32_t codepoint) const
+{
+	if (const auto glyph = mGlyphs.find(codepoint))
 	{
-		throw std::runtime_error("Font::getGlyph() - "
-					 "can't add the glyph to the map");
+		return *glyph;
 	}
 
-	mPositionX += bmWidth + 2 * PADDING;
+	if (!rasterize(mFace, codepoint, mBitmap))
+	{
+		throw std::runtime_error(
+			"Font::getGlyph() - cannot load the glyph for codepoint "
+			+ std::to_string(codepoint));
+	}
 
-	return it->second;
+	const auto &glyph = addGlyph(mBitmap);
+	uploadPages();
+	return glyph;
 }
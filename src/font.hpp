@@ -1,17 +1,24 @@
 #pragma once
 
+#include <deque>
 #include <filesystem>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 
 #include <glm/glm.hpp>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
+#include "codepointmap.hpp"
 #include "color.hpp"
+#include "rect.hpp"
+#include "skylinepacker.hpp"
 #include "texture.hpp"
 
+class JobSystem;
 class RenderTarget;
 
 class Font
@@ -24,31 +31,119 @@ public:
 		glm::vec2 size;
 		glm::vec2 bearing;
 		float advance;
+		unsigned page;
+	};
+
+	enum class Mode
+	{
+		Bitmap,         // coverage rasterized at the pixel size
+		DistanceField,  // signed distance field, scales to any size
 	};
 
 public:
 	Font();
 	~Font();
 
-	bool loadFromFile(const std::filesystem::path &path, unsigned size);
+	/**
+	 * Load the font at the given pixel @size.
+	 *
+	 * @param[in] charset UTF-8 characters to rasterize right away;
+	 *            when a cache directory is set the resulting atlas
+	 *            is stored there and loaded back on the next run.
+	 * @param[in] mode In Mode::DistanceField @size is the reference
+	 *            size of the atlas and the font can be drawn at
+	 *            any size with the distance field shader.
+	 */
+	bool loadFromFile(const std::filesystem::path &path, unsigned size,
+	                  const std::string &charset = "", Mode mode = Mode::Bitmap);
+
+	/**
+	 * Set the directory of the pre-baked atlases, an empty path
+	 * disables the cache.
+	 */
+	static void setCacheDirectory(const std::filesystem::path &directory);
+
+	/**
+	 * Set the pool that rasterizes the glyphs of prefetch(), a
+	 * null pointer rasterizes them on the calling thread.
+	 */
+	static void setJobSystem(JobSystem *jobs);
 
-	glm::vec2 getSize(const std::string &text) const;
+	/**
+	 * Get the size of the @text drawn at @characterSize pixels,
+	 * zero means the size the font was loaded with.
+	 */
+	glm::vec2 getSize(const std::string &text, unsigned characterSize = 0) const;
 
-	const Texture &getTexture() const;
+	/**
+	 * Rasterize the missing glyphs of the UTF-8 @text on the job
+	 * system, then pack and upload them.
+	 */
+	void prefetch(const std::string &text) const;
+	void prefetch(std::u32string_view codepoints) const;
+
+	const Texture &getTexture(unsigned page = 0) const;
+	unsigned getPageCount() const;
 	const Glyph &getGlyph(char32_t codepoint) const;
-	float getLineHeight() const;
+	float getLineHeight(unsigned characterSize = 0) const;
+	float getScale(unsigned characterSize) const;
+	Mode getMode() const;
 
 private:
-	void resizeTexture(unsigned newWidth, unsigned newHeight) const;
+	struct Page
+	{
+		Texture texture;
+		SkylinePacker packer;
+		// glyphs packed but not uploaded, pixels one after the other
+		std::vector<IntRect> pending;
+		std::vector<std::uint8_t> staging;
+	};
+
+	struct Bitmap
+	{
+		char32_t codepoint;
+		bool valid;
+		unsigned width;     // including the padding
+		unsigned height;
+		std::vector<std::uint8_t> pixels;
+		glm::vec2 bearing;
+		float advance;
+	};
+
+	struct Rasterizer
+	{
+		FT_Library library;
+		FT_Face face;
+	};
+
+	bool openFace(FT_Library &library, FT_Face &face) const;
+	void closeFaces();
+
+	bool rasterize(FT_Face face, char32_t codepoint, Bitmap &bitmap) const;
+	const Glyph &addGlyph(const Bitmap &bitmap) const;
+	void uploadPages() const;
+
+	unsigned allocateGlyph(unsigned width, unsigned height, glm::ivec2 &pos) const;
+	void resizeTexture(unsigned page, unsigned newWidth, unsigned newHeight) const;
+
+	bool loadCache(const std::filesystem::path &path,
+	               std::uint64_t fontHash, std::uint64_t charsetHash);
+	void saveCache(const std::filesystem::path &path,
+	               std::uint64_t fontHash, std::uint64_t charsetHash) const;
 
 private:
-	mutable std::unordered_map<char32_t, Glyph> mGlyphs;
-	mutable std::vector<std::uint8_t> mPixelBuffer;
-	mutable Texture mTexture;
+	mutable CodepointMap<Glyph> mGlyphs;
+	mutable Bitmap mBitmap;
+	// NOTE: the render target keeps pointers to the textures
+	// of the pages, a deque doesn't move them when it grows.
+	mutable std::deque<Page> mPages;
+	// the faces are created from memory, one for each range of
+	// glyphs rasterized in parallel
+	std::string mFontData;
 	FT_Library mFT;
 	mutable FT_Face mFace;
+	mutable std::vector<Rasterizer> mRasterizers;
 	float mLineHeight;
-	mutable int mPositionX;
-	mutable int mPositionY;
-	mutable int mMaxHeight;
+	unsigned mPixelSize;
+	Mode mMode;
 };
@@ -10,8 +10,12 @@
 
 GameView::GameView(ViewStack &stack, const Context &context)
 	: mViewStack(stack)
+	, mAudio(*context.audio)
 	, mWindow(*context.window)
+	, mInput(*context.input)
 	, mCamera({0.f, 0.f}, context.window->getSize())
+	, mRenderCamera()
+	, mPreviousCameraPosition(mCamera.getPosition())
 	, mPlayer(
 		mCamera,
 		context.textures->get(TextureID::SpriteSheet),
@@ -22,7 +26,8 @@ GameView::GameView(ViewStack &stack, const Context &context)
 		context.textures->get(TextureID::SpriteSheet), 50, 50)
 {
 	mCamera.setWorldRectangle({{0.f, 0.f}, {1600.f, 1600.f}});
-	context.target->setCamera(mCamera);
+	mRenderCamera = mCamera;
+	context.target->setCamera(mRenderCamera);
 
 	mTileMap.addTile({{0.f, 0.f}, {32.f, 32.f}});
 	mTileMap.addTile({{32.f, 0.f}, {32.f, 32.f}});
@@ -38,23 +43,24 @@ GameView::GameView(ViewStack &stack, const Context &context)
 bool
 GameView::update(float dt)
 {
-	mPlayer.update(mWindow, dt);
+	mPreviousCameraPosition = mCamera.getPosition();
+	mPlayer.update(mInput, dt);
+	mAudio.setListenerPosition(mCamera.getCenter());
 	return true;
 }
 
-bool
-GameView::handleEvent(const Event &)
-{
-	return false;
-}
-
 void
-GameView::render(RenderTarget &target)
+GameView::render(RenderTarget &target, float alpha)
 {
+	// draw between the last two updates
+	mRenderCamera = mCamera;
+	mRenderCamera.setPosition(
+		glm::mix(mPreviousCameraPosition, mCamera.getPosition(), alpha));
+
 	target.beginBatch();
 	target.clear(Color::White);
 	target.draw(mTileMap);
-	mPlayer.draw(target);
+	mPlayer.draw(target, alpha);
 	target.endBatch();
 	target.draw();
 }
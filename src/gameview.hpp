@@ -3,7 +3,9 @@
 #include "view.hpp"
 #include "viewstack.hpp"
 
+#include "audiodevice.hpp"
 #include "camera.hpp"
+#include "inputstate.hpp"
 #include "player.hpp"
 #include "sprite.hpp"
 #include "tilemap.hpp"
@@ -16,13 +18,16 @@ public:
 	virtual ~GameView() override = default;
 
 	virtual bool update(float dt) override;
-	virtual bool handleEvent(const Event &event) override;
-	virtual void render(RenderTarget &target) override;
+	virtual void render(RenderTarget &target, float alpha) override;
 
 private:
 	ViewStack &mViewStack;
+	AudioDevice &mAudio;
 	Window &mWindow;
+	const InputState &mInput;
 	Camera mCamera;
+	Camera mRenderCamera;
+	glm::vec2 mPreviousCameraPosition;
 	Player mPlayer;
 	TileMap mTileMap;
 };
@@ -0,0 +1,236 @@
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "inputrecord.hpp"
+
+namespace
+{
+const char RECORD_MAGIC[4] = { 'R', 'R', 'I', 'R' };
+const std::uint32_t RECORD_VERSION = 2;
+
+// every record starts with a tag: the index of an event or a frame
+const std::uint8_t FRAME_TAG = 0xFF;
+static_assert(std::variant_size_v<Event> < FRAME_TAG, "Too many events");
+
+// the values are stored little-endian in 1, 4 or 8 bytes whatever
+// the platform, the integers are two's complement
+template <typename T>
+void
+write(std::ostream &out, T value)
+{
+	static_assert(std::is_arithmetic_v<T>);
+	static_assert(sizeof(T) == 1 || sizeof(T) == 4 || sizeof(T) == 8);
+	using Bits = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+		std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>;
+	auto bits = std::bit_cast<Bits>(value);
+	char bytes[sizeof(T)];
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+	{
+		bytes[i] = static_cast<char>(bits >> (i * 8));
+	}
+	out.write(bytes, sizeof(bytes));
+}
+
+template <typename T>
+bool
+read(std::istream &in, T &value)
+{
+	static_assert(std::is_arithmetic_v<T>);
+	static_assert(sizeof(T) == 1 || sizeof(T) == 4 || sizeof(T) == 8);
+	using Bits = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+		std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>;
+	unsigned char bytes[sizeof(T)];
+	if (!in.read(reinterpret_cast<char *>(bytes), sizeof(bytes)))
+	{
+		return false;
+	}
+	Bits bits = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+	{
+		bits |= static_cast<Bits>(bytes[i]) << (i * 8);
+	}
+	value = std::bit_cast<T>(bits);
+	return true;
+}
+
+// the fields of the events stored in the recording, all but the
+// window pointer that is attributed on replay
+auto fields(WindowMoved &e)         { return std::tie(e.x, e.y); }
+auto fields(WindowResized &e)       { return std::tie(e.width, e.height); }
+auto fields(WindowScaleChanged &e)  { return std::tie(e.x, e.y); }
+auto fields(KeyPressed &e)          { return std::tie(e.key, e.scancode, e.mod); }
+auto fields(KeyRepeated &e)         { return std::tie(e.key, e.scancode, e.mod); }
+auto fields(KeyReleased &e)         { return std::tie(e.key, e.scancode, e.mod); }
+auto fields(MouseButtonPressed &e)  { return std::tie(e.button, e.mods); }
+auto fields(MouseButtonReleased &e) { return std::tie(e.button, e.mods); }
+auto fields(MouseCursorMoved &e)    { return std::tie(e.x, e.y); }
+auto fields(MouseScrolled &e)       { return std::tie(e.x, e.y); }
+auto fields(CodepointInput &e)      { return std::tie(e.codepoint); }
+auto fields(FramebufferResized &e)  { return std::tie(e.width, e.height); }
+
+template <typename T>
+std::tuple<>
+fields(T &)
+{
+	static_assert(sizeof(T) == sizeof(Window *), "Store the fields of the event");
+	return {};
+}
+
+template <std::size_t I>
+bool
+readEvent(std::istream &in, Event &event, Window *window)
+{
+	using T = std::variant_alternative_t<I, Event>;
+	T value{};
+	value.window = window;
+	bool success = std::apply([&in](auto &... field) {
+		return (read(in, field) && ...);
+	}, fields(value));
+	if (!success)
+	{
+		return false;
+	}
+	event = value;
+	return true;
+}
+
+template <std::size_t... I>
+bool
+readEvent(std::istream &in, std::size_t index, Event &event, Window *window,
+          std::index_sequence<I...>)
+{
+	bool success = false;
+	((I == index && (success = readEvent<I>(in, event, window), true)) || ...);
+	return success;
+}
+}
+
+bool
+InputRecorder::open(const std::filesystem::path &path, unsigned seed)
+{
+	mFile.open(path, std::ios::out|std::ios::binary|std::ios::trunc);
+	if (!mFile)
+	{
+		std::cerr << "InputRecorder::open() - cannot write " << path << "\n";
+		return false;
+	}
+	mFile.write(RECORD_MAGIC, sizeof(RECORD_MAGIC));
+	write(mFile, RECORD_VERSION);
+	write(mFile, static_cast<std::uint32_t>(seed));
+	return true;
+}
+
+void
+InputRecorder::close()
+{
+	mFile.close();
+}
+
+bool
+InputRecorder::isOpen() const
+{
+	return mFile.is_open();
+}
+
+void
+InputRecorder::beginFrame(float dt)
+{
+	write(mFile, FRAME_TAG);
+	write(mFile, dt);
+}
+
+void
+InputRecorder::record(const Event &event)
+{
+	write(mFile, static_cast<std::uint8_t>(event.index()));
+	std::visit([this](const auto &value) {
+		auto copy = value;
+		std::apply([this](const auto &... field) {
+			(write(mFile, field), ...);
+		}, fields(copy));
+	}, event);
+}
+
+InputReplay::InputReplay()
+	: mFile()
+	, mSeed(0)
+{
+}
+
+bool
+InputReplay::open(const std::filesystem::path &path)
+{
+	mFile.open(path, std::ios::in|std::ios::binary);
+	char magic[4];
+	std::uint32_t version, seed;
+	if (!mFile
+	    || !mFile.read(magic, sizeof(magic))
+	    || !std::equal(magic, magic + 4, RECORD_MAGIC)
+	    || !read(mFile, version) || version != RECORD_VERSION
+	    || !read(mFile, seed))
+	{
+		std::cerr << "InputReplay::open() - cannot read " << path << "\n";
+		mFile.close();
+		return false;
+	}
+	mSeed = seed;
+	return true;
+}
+
+void
+InputReplay::close()
+{
+	mFile.close();
+}
+
+bool
+InputReplay::isOpen() const
+{
+	return mFile.is_open();
+}
+
+unsigned
+InputReplay::getSeed() const
+{
+	return mSeed;
+}
+
+bool
+InputReplay::nextFrame(float &dt)
+{
+	// skip the events left in the current frame
+	std::uint8_t tag;
+	while (read(mFile, tag) && tag != FRAME_TAG)
+	{
+		Event event;
+		if (!readEvent(mFile, tag, event, nullptr,
+		               std::make_index_sequence<std::variant_size_v<Event>>()))
+		{
+			return false;
+		}
+	}
+	return mFile && read(mFile, dt);
+}
+
+bool
+InputReplay::pop(Event &event, Window *window)
+{
+	std::uint8_t tag;
+	if (mFile.peek() == FRAME_TAG || !read(mFile, tag))
+	{
+		return false;
+	}
+	if (!readEvent(mFile, tag, event, window,
+	               std::make_index_sequence<std::variant_size_v<Event>>()))
+	{
+		std::cerr << "InputReplay::pop() - corrupted recording\n";
+		mFile.setstate(std::ios::failbit);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+#include "event.hpp"
+
+class Window;
+
+/**
+ * Write the random seed, the time step of every frame and the events
+ * drained in it to a compact binary file, every field stored
+ * little-endian with a fixed width so that the same input gives the
+ * same file on any platform.
+ */
+class InputRecorder
+{
+public:
+	bool open(const std::filesystem::path &path, unsigned seed);
+	void close();
+	bool isOpen() const;
+
+	void beginFrame(float dt);
+	void record(const Event &event);
+
+private:
+	std::ofstream mFile;
+};
+
+/**
+ * Read back a file written by InputRecorder, frame by frame.
+ */
+class InputReplay
+{
+public:
+	InputReplay();
+
+	bool open(const std::filesystem::path &path);
+	void close();
+	bool isOpen() const;
+
+	unsigned getSeed() const;
+
+	/**
+	 * Advance to the next frame.
+	 *
+	 * @param[out] dt Time step of the frame.
+	 *
+	 * @retval true the frame has been read.
+	 * @retval false the recording is over.
+	 */
+	bool nextFrame(float &dt);
+
+	/**
+	 * Pop the next event of the current frame, attributing it to
+	 * the @window.
+	 */
+	bool pop(Event &event, Window *window);
+
+private:
+	std::ifstream mFile;
+	unsigned mSeed;
+};
@@ -0,0 +1,123 @@
+#include "inputstate.hpp"
+
+namespace
+{
+template <std::size_t N>
+bool
+test(const std::bitset<N> &bits, int index)
+{
+	return index >= 0 && static_cast<std::size_t>(index) < N && bits[index];
+}
+}
+
+InputState::InputState()
+	: mKeys()
+	, mKeysPressed()
+	, mKeysReleased()
+	, mButtons()
+	, mButtonsPressed()
+	, mButtonsReleased()
+	, mCursor(0.0)
+{
+}
+
+void
+InputState::endStep()
+{
+	mKeysPressed.reset();
+	mKeysReleased.reset();
+	mButtonsPressed.reset();
+	mButtonsReleased.reset();
+}
+
+void
+InputState::handleEvent(const Event &event)
+{
+	if (const auto ep(std::get_if<KeyPressed>(&event)); ep)
+	{
+		if (ep->key >= 0 && static_cast<std::size_t>(ep->key) < KEY_COUNT)
+		{
+			mKeys.set(ep->key);
+			mKeysPressed.set(ep->key);
+		}
+	}
+	else if (const auto ep(std::get_if<KeyReleased>(&event)); ep)
+	{
+		if (ep->key >= 0 && static_cast<std::size_t>(ep->key) < KEY_COUNT)
+		{
+			mKeys.reset(ep->key);
+			mKeysReleased.set(ep->key);
+		}
+	}
+	else if (const auto ep(std::get_if<MouseButtonPressed>(&event)); ep)
+	{
+		if (ep->button >= 0 && static_cast<std::size_t>(ep->button) < BUTTON_COUNT)
+		{
+			mButtons.set(ep->button);
+			mButtonsPressed.set(ep->button);
+		}
+	}
+	else if (const auto ep(std::get_if<MouseButtonReleased>(&event)); ep)
+	{
+		if (ep->button >= 0 && static_cast<std::size_t>(ep->button) < BUTTON_COUNT)
+		{
+			mButtons.reset(ep->button);
+			mButtonsReleased.set(ep->button);
+		}
+	}
+	else if (const auto ep(std::get_if<MouseCursorMoved>(&event)); ep)
+	{
+		mCursor = glm::dvec2(ep->x, ep->y);
+	}
+	else if (std::holds_alternative<WindowDefocused>(event))
+	{
+		// the releases go to the focused window, don't leave
+		// the keys stuck down
+		mKeysReleased |= mKeys;
+		mButtonsReleased |= mButtons;
+		mKeys.reset();
+		mButtons.reset();
+	}
+}
+
+bool
+InputState::isKeyDown(int key) const
+{
+	return test(mKeys, key);
+}
+
+bool
+InputState::isKeyPressed(int key) const
+{
+	return test(mKeysPressed, key);
+}
+
+bool
+InputState::isKeyReleased(int key) const
+{
+	return test(mKeysReleased, key);
+}
+
+bool
+InputState::isButtonDown(int button) const
+{
+	return test(mButtons, button);
+}
+
+bool
+InputState::isButtonPressed(int button) const
+{
+	return test(mButtonsPressed, button);
+}
+
+bool
+InputState::isButtonReleased(int button) const
+{
+	return test(mButtonsReleased, button);
+}
+
+glm::dvec2
+InputState::getCursorPosition() const
+{
+	return mCursor;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <bitset>
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "event.hpp"
+
+/**
+ * State of the keyboard and of the mouse built from the events, with
+ * the keys and the buttons pressed or released since the last update
+ * step. The presses and releases are kept until a step consumes them,
+ * so none is lost when a frame runs no step and none is seen twice
+ * when a frame runs many steps.
+ *
+ * It's a plain value and can be copied to take a snapshot.
+ */
+class InputState
+{
+public:
+	InputState();
+
+	/**
+	 * Forget the presses and releases seen by the update step
+	 * that just ended.
+	 */
+	void endStep();
+	void handleEvent(const Event &event);
+
+	bool isKeyDown(int key) const;
+	bool isKeyPressed(int key) const;
+	bool isKeyReleased(int key) const;
+
+	bool isButtonDown(int button) const;
+	bool isButtonPressed(int button) const;
+	bool isButtonReleased(int button) const;
+
+	glm::dvec2 getCursorPosition() const;
+
+private:
+	static constexpr std::size_t KEY_COUNT = GLFW_KEY_LAST + 1;
+	static constexpr std::size_t BUTTON_COUNT = GLFW_MOUSE_BUTTON_LAST + 1;
+
+private:
+	std::bitset<KEY_COUNT> mKeys;
+	std::bitset<KEY_COUNT> mKeysPressed;
+	std::bitset<KEY_COUNT> mKeysReleased;
+	std::bitset<BUTTON_COUNT> mButtons;
+	std::bitset<BUTTON_COUNT> mButtonsPressed;
+	std::bitset<BUTTON_COUNT> mButtonsReleased;
+	glm::dvec2 mCursor;
+};
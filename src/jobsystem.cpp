@@ -0,0 +1,348 @@
+#include <algorithm>
+
+#include "jobsystem.hpp"
+
+namespace
+{
+// ranges per worker when parallelFor() picks the grain
+const std::size_t RangesPerWorker = 4;
+
+// the JobSystem and the worker of the current thread
+thread_local const JobSystem *currentSystem = nullptr;
+thread_local unsigned currentWorker = -1U;
+}
+
+bool
+JobSystem::Handle::isDone() const
+{
+	return !mJob || mJob->done.load(std::memory_order_acquire);
+}
+
+JobSystem::Handle::Handle(std::shared_ptr<Job> job)
+	: mJob(std::move(job))
+{
+}
+
+JobSystem::JobSystem(unsigned threads)
+	: mWorkers()
+	, mQueued(0)
+	, mRunning(true)
+	, mSleepMutex()
+	, mWake()
+	, mFrameStart(Clock::now())
+	, mFrameStats()
+	, mTotalStats()
+	, mFrameCount(0)
+{
+	if (threads == 0)
+	{
+		threads = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+	}
+
+	currentSystem = this;
+	currentWorker = 0;
+	for (unsigned i = 0; i <= threads; ++i)
+	{
+		auto worker = std::make_unique<Worker>();
+		worker->busy = 0;
+		mWorkers.push_back(std::move(worker));
+	}
+	for (unsigned i = 1; i <= threads; ++i)
+	{
+		mWorkers[i]->thread = std::thread(&JobSystem::run, this, i);
+	}
+
+	mFrameStats.resize(mWorkers.size(), {0.f, 0.f});
+	mTotalStats.resize(mWorkers.size(), {0.f, 0.f});
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock(mSleepMutex);
+		mRunning = false;
+	}
+	mWake.notify_all();
+	for (auto &worker : mWorkers)
+	{
+		if (worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+
+	// the jobs queued on worker 0 after the others stopped
+	while (auto job = findJob(0))
+	{
+		execute(*job, 0);
+	}
+
+	if (currentSystem == this)
+	{
+		currentSystem = nullptr;
+		currentWorker = -1U;
+	}
+}
+
+JobSystem::Handle
+JobSystem::schedule(std::function<void()> work, std::span<const Handle> dependencies)
+{
+	auto job = std::make_shared<Job>();
+	job->work = std::move(work);
+	job->waiting = 1;
+	job->done = false;
+	for (const auto &dependency : dependencies)
+	{
+		if (!dependency.mJob)
+		{
+			continue;
+		}
+		std::lock_guard lock(dependency.mJob->mutex);
+		if (!dependency.mJob->done)
+		{
+			job->waiting++;
+			dependency.mJob->dependents.push_back(job);
+		}
+		else if (dependency.mJob->error)
+		{
+			// the dependencies still running write it too
+			std::lock_guard jobLock(job->mutex);
+			if (!job->error)
+			{
+				job->error = dependency.mJob->error;
+			}
+		}
+	}
+
+	// the dependencies might be done already
+	if (job->waiting.fetch_sub(1) == 1)
+	{
+		enqueue(job);
+	}
+	return Handle(std::move(job));
+}
+
+JobSystem::Handle
+JobSystem::parallelFor(std::size_t count, std::size_t grain,
+                       std::function<void(std::size_t, std::size_t)> work,
+                       std::span<const Handle> dependencies)
+{
+	if (grain == 0)
+	{
+		grain = std::max<std::size_t>(
+			count / (mWorkers.size() * RangesPerWorker), 1);
+	}
+
+	auto shared = std::make_shared<decltype(work)>(std::move(work));
+	std::vector<Handle> ranges;
+	ranges.reserve((count + grain - 1) / grain);
+	for (std::size_t begin = 0; begin < count; begin += grain)
+	{
+		std::size_t end = std::min(begin + grain, count);
+		ranges.push_back(schedule([shared, begin, end] {
+			(*shared)(begin, end);
+		}, dependencies));
+	}
+	if (ranges.empty())
+	{
+		return schedule([] {}, dependencies);
+	}
+	return schedule([] {}, ranges);
+}
+
+void
+JobSystem::wait(const Handle &handle)
+{
+	unsigned index = getCurrentWorker();
+	while (!handle.isDone())
+	{
+		if (auto job = findJob(index))
+		{
+			execute(*job, index);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	if (handle.mJob && handle.mJob->error)
+	{
+		std::rethrow_exception(handle.mJob->error);
+	}
+}
+
+unsigned
+JobSystem::getWorkerCount() const
+{
+	return mWorkers.size();
+}
+
+void
+JobSystem::endFrame()
+{
+	auto now = Clock::now();
+	float frame = std::chrono::duration<float>(now - mFrameStart).count();
+	mFrameStart = now;
+
+	for (std::size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		std::chrono::nanoseconds busy(mWorkers[i]->busy.exchange(0));
+		auto &stats = mFrameStats[i];
+		stats.busy = std::chrono::duration<float>(busy).count();
+		stats.idle = std::max(frame - stats.busy, 0.f);
+		mTotalStats[i].busy += stats.busy;
+		mTotalStats[i].idle += stats.idle;
+	}
+	mFrameCount++;
+}
+
+std::span<const JobSystem::WorkerStats>
+JobSystem::getFrameStats() const
+{
+	return mFrameStats;
+}
+
+void
+JobSystem::report(std::ostream &out) const
+{
+	if (mFrameCount == 0)
+	{
+		return;
+	}
+
+	out << "job workers over " << mFrameCount << " frames (ms per frame):\n";
+	for (std::size_t i = 0; i < mTotalStats.size(); ++i)
+	{
+		const auto &stats = mTotalStats[i];
+		out << "  worker " << i
+		    << " busy " << stats.busy * 1000.f / mFrameCount
+		    << " idle " << stats.idle * 1000.f / mFrameCount
+		    << "\n";
+	}
+}
+
+void
+JobSystem::run(unsigned index)
+{
+	currentSystem = this;
+	currentWorker = index;
+	for (;;)
+	{
+		if (auto job = findJob(index))
+		{
+			execute(*job, index);
+			continue;
+		}
+
+		// leave only when all the queues are empty
+		std::unique_lock lock(mSleepMutex);
+		if (!mRunning && mQueued == 0)
+		{
+			break;
+		}
+		mWake.wait(lock, [this] {
+			return mQueued > 0 || !mRunning;
+		});
+	}
+}
+
+unsigned
+JobSystem::getCurrentWorker() const
+{
+	// the threads out of the pool share the queue of worker 0
+	return currentSystem == this ? currentWorker : 0;
+}
+
+void
+JobSystem::enqueue(std::shared_ptr<Job> job)
+{
+	auto &worker = *mWorkers[getCurrentWorker()];
+	{
+		std::lock_guard lock(worker.mutex);
+		worker.jobs.push_back(std::move(job));
+	}
+	mQueued++;
+
+	// don't let a worker miss the wake up between its check and
+	// its wait
+	{
+		std::lock_guard lock(mSleepMutex);
+	}
+	mWake.notify_one();
+}
+
+std::shared_ptr<JobSystem::Job>
+JobSystem::findJob(unsigned index)
+{
+	std::shared_ptr<Job> job;
+	{
+		auto &own = *mWorkers[index];
+		std::lock_guard lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+		}
+	}
+
+	// steal the oldest job of another worker
+	for (std::size_t i = 1; !job && i < mWorkers.size(); ++i)
+	{
+		auto &victim = *mWorkers[(index + i) % mWorkers.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+		}
+	}
+
+	if (job)
+	{
+		mQueued--;
+	}
+	return job;
+}
+
+void
+JobSystem::execute(Job &job, unsigned index)
+{
+	// a failed dependency fails the job without running it
+	auto start = Clock::now();
+	if (!job.error)
+	{
+		try
+		{
+			job.work();
+		}
+		catch (...)
+		{
+			job.error = std::current_exception();
+		}
+	}
+	auto elapsed = Clock::now() - start;
+	mWorkers[index]->busy += std::chrono::duration_cast<
+		std::chrono::nanoseconds>(elapsed).count();
+
+	std::vector<std::shared_ptr<Job>> dependents;
+	{
+		std::lock_guard lock(job.mutex);
+		job.done.store(true, std::memory_order_release);
+		dependents.swap(job.dependents);
+	}
+	for (auto &dependent : dependents)
+	{
+		if (job.error)
+		{
+			std::lock_guard lock(dependent->mutex);
+			if (!dependent->error)
+			{
+				dependent->error = job.error;
+			}
+		}
+		if (dependent->waiting.fetch_sub(1) == 1)
+		{
+			enqueue(std::move(dependent));
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool of worker threads running jobs, every worker takes the jobs
+ * from the back of its own queue and, when it runs out of them,
+ * steals from the front of the queues of the others.
+ *
+ * The jobs can be scheduled from any thread. The thread that creates
+ * the JobSystem counts as worker 0: it owns a queue but runs jobs
+ * only while it waits for one of them.
+ *
+ * A job that throws is done all the same, the jobs depending on it
+ * are skipped and wait() rethrows the exception.
+ */
+class JobSystem
+{
+private:
+	struct Job;
+
+public:
+	/**
+	 * Reference to a scheduled job, a default constructed handle
+	 * refers to no job and is always done.
+	 */
+	class Handle
+	{
+	public:
+		Handle() = default;
+
+		bool isDone() const;
+
+	private:
+		friend class JobSystem;
+		explicit Handle(std::shared_ptr<Job> job);
+
+	private:
+		std::shared_ptr<Job> mJob;
+	};
+
+	struct WorkerStats
+	{
+		float busy;  // seconds spent running jobs
+		float idle;  // seconds spent without jobs
+	};
+
+public:
+	/**
+	 * Start @threads workers, zero means one less than the number
+	 * of hardware threads.
+	 */
+	explicit JobSystem(unsigned threads = 0);
+
+	/**
+	 * Run the jobs still queued and stop the workers.
+	 */
+	~JobSystem();
+
+	JobSystem(const JobSystem &) = delete;
+	JobSystem& operator=(const JobSystem &) = delete;
+
+	/**
+	 * Run @work after all the @dependencies are done.
+	 */
+	Handle schedule(std::function<void()> work,
+	                std::span<const Handle> dependencies = {});
+
+	/**
+	 * Run @work(begin, end) over the ranges of at most @grain
+	 * indices covering [0, @count), zero picks the grain from the
+	 * number of workers.
+	 *
+	 * @return a handle done when all the ranges are done.
+	 */
+	Handle parallelFor(std::size_t count, std::size_t grain,
+	                   std::function<void(std::size_t, std::size_t)> work,
+	                   std::span<const Handle> dependencies = {});
+
+	/**
+	 * Run the queued jobs until the job of @handle is done, then
+	 * rethrow the exception of the job or of its dependencies.
+	 */
+	void wait(const Handle &handle);
+
+	unsigned getWorkerCount() const;
+
+	/**
+	 * Close the frame and measure the busy and idle time of every
+	 * worker since the previous call.
+	 */
+	void endFrame();
+
+	/**
+	 * Get the time of the workers in the last frame, indexed by
+	 * worker.
+	 */
+	std::span<const WorkerStats> getFrameStats() const;
+
+	/**
+	 * Print the average busy and idle time per frame of every
+	 * worker.
+	 */
+	void report(std::ostream &out) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Job
+	{
+		std::function<void()> work;
+		std::exception_ptr error;  // written before done
+		std::atomic<unsigned> waiting;
+		std::atomic<bool> done;
+		std::mutex mutex;
+		std::vector<std::shared_ptr<Job>> dependents;
+	};
+
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::shared_ptr<Job>> jobs;
+		std::atomic<std::uint64_t> busy;
+		std::thread thread;
+	};
+
+private:
+	void run(unsigned index);
+	unsigned getCurrentWorker() const;
+	void enqueue(std::shared_ptr<Job> job);
+	std::shared_ptr<Job> findJob(unsigned index);
+	void execute(Job &job, unsigned index);
+
+private:
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	std::atomic<unsigned> mQueued;
+	std::atomic<bool> mRunning;
+	std::mutex mSleepMutex;
+	std::condition_variable mWake;
+
+	// utilization
+	Clock::time_point mFrameStart;
+	std::vector<WorkerStats> mFrameStats;
+	std::vector<WorkerStats> mTotalStats;
+	std::uint64_t mFrameCount;
+};
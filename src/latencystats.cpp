@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "latencystats.hpp"
+
+LatencyStats::LatencyStats()
+	: mSamples()
+	, mCount(0)
+	, mInputTime(0.0)
+	, mHasInput(false)
+{
+}
+
+void
+LatencyStats::beginFrame()
+{
+	mHasInput = false;
+}
+
+void
+LatencyStats::addInput(double time)
+{
+	if (!mHasInput || time < mInputTime)
+	{
+		mInputTime = time;
+		mHasInput = true;
+	}
+}
+
+void
+LatencyStats::mark(Stage stage, double time)
+{
+	if (!mHasInput)
+	{
+		return;
+	}
+
+	auto index = static_cast<std::size_t>(stage);
+	mSamples[index][mCount % SAMPLE_COUNT] = time - mInputTime;
+	if (stage == Stage::Present)
+	{
+		mCount++;
+	}
+}
+
+std::size_t
+LatencyStats::getSampleCount() const
+{
+	return std::min(mCount, SAMPLE_COUNT);
+}
+
+double
+LatencyStats::getPercentile(Stage stage, double percentile) const
+{
+	std::size_t count = getSampleCount();
+	if (count == 0)
+	{
+		return 0.0;
+	}
+
+	const auto &samples = mSamples[static_cast<std::size_t>(stage)];
+	std::vector<float> sorted(samples.begin(), samples.begin() + count);
+	auto rank = static_cast<std::size_t>(
+		std::ceil(percentile / 100.0 * count));
+	rank = std::clamp<std::size_t>(rank, 1, count) - 1;
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+	return sorted[rank];
+}
+
+void
+LatencyStats::report(std::ostream &out) const
+{
+	const char *names[] = { "update", "render", "present" };
+	out << "input latency over " << getSampleCount() << " frames (ms):\n";
+	for (std::size_t i = 0; i < STAGE_COUNT; ++i)
+	{
+		auto stage = static_cast<Stage>(i);
+		out << "  " << names[i]
+		    << " p50 " << getPercentile(stage, 50.0) * 1000.0
+		    << " p90 " << getPercentile(stage, 90.0) * 1000.0
+		    << " p99 " << getPercentile(stage, 99.0) * 1000.0
+		    << " max " << getPercentile(stage, 100.0) * 1000.0
+		    << "\n";
+	}
+}
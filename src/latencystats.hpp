@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * Latency from the oldest input event consumed in a frame to the end
+ * of the update, of the render and to the present of that frame,
+ * over the most recent frames with input.
+ */
+class LatencyStats
+{
+public:
+	enum class Stage
+	{
+		Update,
+		Render,
+		Present,
+	};
+
+public:
+	LatencyStats();
+
+	void beginFrame();
+
+	/**
+	 * Account an input event stamped at @time consumed in the
+	 * current frame.
+	 */
+	void addInput(double time);
+
+	/**
+	 * Mark the end of a stage of the current frame at @time.
+	 */
+	void mark(Stage stage, double time);
+
+	std::size_t getSampleCount() const;
+
+	/**
+	 * Get the @percentile (0-100) of the latency to @stage in
+	 * seconds, zero without samples.
+	 */
+	double getPercentile(Stage stage, double percentile) const;
+
+	void report(std::ostream &out) const;
+
+private:
+	static constexpr std::size_t SAMPLE_COUNT = 1024;
+	static constexpr std::size_t STAGE_COUNT = 3;
+
+private:
+	std::array<std::array<float, SAMPLE_COUNT>, STAGE_COUNT> mSamples;
+	std::size_t mCount;
+	double mInputTime;
+	bool mHasInput;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * Bounded lock-free queue with many producers and a single
+ * consumer, every cell carries a sequence number telling whether
+ * it is ready to be written or read.
+ */
+template <typename T, std::size_t Size>
+class MPSCQueue
+{
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0,
+	              "The size must be a power of two");
+
+public:
+	MPSCQueue();
+
+	MPSCQueue(const MPSCQueue &) = delete;
+	MPSCQueue& operator=(const MPSCQueue &) = delete;
+
+	/**
+	 * Add a value from any thread.
+	 *
+	 * @retval true the value has been added.
+	 * @retval false the queue is full.
+	 */
+	bool push(T value);
+
+	/**
+	 * Remove the oldest value, only from the consumer thread.
+	 *
+	 * @retval true a value has been moved into @value.
+	 * @retval false the queue is empty.
+	 */
+	bool pop(T &value);
+
+private:
+	static constexpr std::size_t MASK = Size - 1;
+
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+private:
+	std::array<Cell, Size> mCells;
+	alignas(64) std::atomic<std::size_t> mWrite;
+	alignas(64) std::size_t mRead;
+};
+
+template <typename T, std::size_t Size>
+MPSCQueue<T, Size>::MPSCQueue()
+	: mCells()
+	, mWrite(0)
+	, mRead(0)
+{
+	for (std::size_t i = 0; i < Size; ++i)
+	{
+		mCells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T, std::size_t Size>
+bool
+MPSCQueue<T, Size>::push(T value)
+{
+	Cell *cell;
+	std::size_t pos = mWrite.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		cell = &mCells[pos & MASK];
+		std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		auto diff = static_cast<std::intptr_t>(sequence)
+			- static_cast<std::intptr_t>(pos);
+		if (diff == 0)
+		{
+			// the cell is free, try to claim it
+			if (mWrite.compare_exchange_weak(pos, pos + 1,
+			                                 std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// the consumer didn't release the cell yet
+			return false;
+		}
+		else
+		{
+			// another producer claimed the cell
+			pos = mWrite.load(std::memory_order_relaxed);
+		}
+	}
+	cell->value = std::move(value);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T, std::size_t Size>
+bool
+MPSCQueue<T, Size>::pop(T &value)
+{
+	Cell &cell = mCells[mRead & MASK];
+	if (cell.sequence.load(std::memory_order_acquire) != mRead + 1)
+	{
+		return false;
+	}
+	value = std::move(cell.value);
+	cell.sequence.store(mRead + Size, std::memory_order_release);
+	++mRead;
+	return true;
+}
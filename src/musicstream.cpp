@@ -0,0 +1,254 @@
+#include <chrono>
+#include <iostream>
+
+#include "alcheck.hpp"
+#include "musicstream.hpp"
+
+namespace
+{
+// how often the decode thread refills the processed buffers
+const auto PollInterval = std::chrono::milliseconds(10);
+}
+
+MusicStream::MusicStream()
+	: mFile()
+	, mOpen(false)
+	, mSource(0)
+	, mBuffers()
+	, mFormat(0)
+	, mSampleRate(0)
+	, mChunk(BUFFER_SIZE)
+	, mThread()
+	, mStreaming(false)
+	, mPaused(false)
+	, mStateMutex()
+	, mLoop(false)
+{
+}
+
+MusicStream::~MusicStream()
+{
+	close();
+}
+
+bool
+MusicStream::openFromFile(const std::filesystem::path &path)
+{
+	close();
+	if (ov_fopen(path.c_str(), &mFile) != 0)
+	{
+		std::cerr << "MusicStream::openFromFile(" << path
+		          << ") - cannot open the Ogg Vorbis file.\n";
+		return false;
+	}
+
+	auto info = ov_info(&mFile, -1);
+	switch (info->channels)
+	{
+	case 1: mFormat = AL_FORMAT_MONO16; break;
+	case 2: mFormat = AL_FORMAT_STEREO16; break;
+	default:
+		std::cerr << "MusicStream::openFromFile(" << path
+		          << ") - unsupported number of channels.\n";
+		ov_clear(&mFile);
+		return false;
+	}
+	mSampleRate = info->rate;
+
+	alCheck(alGenSources(1, &mSource));
+	alCheck(alGenBuffers(mBuffers.size(), mBuffers.data()));
+	alCheck(alSourcei(mSource, AL_SOURCE_RELATIVE, AL_TRUE));
+	mOpen = true;
+	return true;
+}
+
+void
+MusicStream::close()
+{
+	if (!mOpen)
+	{
+		return;
+	}
+	stop();
+	alCheck(alDeleteSources(1, &mSource));
+	alCheck(alDeleteBuffers(mBuffers.size(), mBuffers.data()));
+	ov_clear(&mFile);
+	mOpen = false;
+}
+
+void
+MusicStream::play()
+{
+	if (!mOpen)
+	{
+		return;
+	}
+	if (mStreaming)
+	{
+		std::lock_guard lock(mStateMutex);
+		if (mPaused)
+		{
+			mPaused = false;
+			alCheck(alSourcePlay(mSource));
+		}
+		return;
+	}
+
+	// the previous thread reached the end of the track, start
+	// again from the beginning
+	if (mThread.joinable())
+	{
+		mThread.join();
+		ov_pcm_seek(&mFile, 0);
+	}
+	mPaused = false;
+	mStreaming = true;
+	mThread = std::thread(&MusicStream::stream, this);
+}
+
+void
+MusicStream::pause()
+{
+	std::lock_guard lock(mStateMutex);
+	if (mStreaming && !mPaused)
+	{
+		mPaused = true;
+		alCheck(alSourcePause(mSource));
+	}
+}
+
+void
+MusicStream::stop()
+{
+	mStreaming = false;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+	if (mOpen)
+	{
+		ov_pcm_seek(&mFile, 0);
+	}
+}
+
+bool
+MusicStream::isPlaying() const
+{
+	return mStreaming && !mPaused;
+}
+
+void
+MusicStream::setLoop(bool loop)
+{
+	mLoop = loop;
+}
+
+void
+MusicStream::setVolume(float volume)
+{
+	if (mOpen)
+	{
+		alCheck(alSourcef(mSource, AL_GAIN, volume));
+	}
+}
+
+bool
+MusicStream::fillBuffer(unsigned buffer)
+{
+	std::size_t size = 0;
+	bool rewound = false;
+	while (size < mChunk.size())
+	{
+		int bitstream;
+		long read = ov_read(&mFile, mChunk.data() + size, mChunk.size() - size,
+		                    0, 2, 1, &bitstream);
+		if (read > 0)
+		{
+			size += read;
+			rewound = false;
+		}
+		else if (read == OV_HOLE)
+		{
+			// recoverable gap in the data
+			continue;
+		}
+		else if (read == 0 && mLoop && !rewound)
+		{
+			ov_pcm_seek(&mFile, 0);
+			rewound = true;
+		}
+		else
+		{
+			if (read < 0)
+			{
+				std::cerr << "MusicStream::fillBuffer() - decode error "
+				          << read << "\n";
+			}
+			break;
+		}
+	}
+	if (size == 0)
+	{
+		return false;
+	}
+	alCheck(alBufferData(buffer, mFormat, mChunk.data(), size, mSampleRate));
+	return true;
+}
+
+void
+MusicStream::stream()
+{
+	// prime the queue with the whole ring
+	unsigned queued = 0;
+	bool finished = false;
+	for (auto buffer : mBuffers)
+	{
+		if (!fillBuffer(buffer))
+		{
+			finished = true;
+			break;
+		}
+		alCheck(alSourceQueueBuffers(mSource, 1, &buffer));
+		queued++;
+	}
+	alCheck(alSourcePlay(mSource));
+
+	while (mStreaming && queued > 0)
+	{
+		int processed;
+		alCheck(alGetSourcei(mSource, AL_BUFFERS_PROCESSED, &processed));
+		while (processed-- > 0)
+		{
+			unsigned buffer;
+			alCheck(alSourceUnqueueBuffers(mSource, 1, &buffer));
+			queued--;
+			if (!finished && fillBuffer(buffer))
+			{
+				alCheck(alSourceQueueBuffers(mSource, 1, &buffer));
+				queued++;
+			}
+			else
+			{
+				finished = true;
+			}
+		}
+
+		// restart the source after an underrun, pause() can't
+		// slip in between the check and the restart
+		{
+			std::lock_guard lock(mStateMutex);
+			int state;
+			alCheck(alGetSourcei(mSource, AL_SOURCE_STATE, &state));
+			if (state != AL_PLAYING && !mPaused && queued > 0)
+			{
+				alCheck(alSourcePlay(mSource));
+			}
+		}
+		std::this_thread::sleep_for(PollInterval);
+	}
+
+	// a stopped source marks all its buffers as processed
+	alCheck(alSourceStop(mSource));
+	alCheck(alSourcei(mSource, AL_BUFFER, 0));
+	mStreaming = false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <vorbis/vorbisfile.h>
+
+/**
+ * Ogg Vorbis track decoded in chunks on a background thread and
+ * played through a small ring of OpenAL buffers, the memory used
+ * doesn't depend on the length of the track.
+ *
+ * The audio context must be current while the stream is open.
+ */
+class MusicStream
+{
+public:
+	MusicStream();
+	~MusicStream();
+
+	MusicStream(const MusicStream &) = delete;
+	MusicStream& operator=(const MusicStream &) = delete;
+
+	bool openFromFile(const std::filesystem::path &path);
+	void close();
+
+	void play();
+	void pause();
+	void stop();
+
+	bool isPlaying() const;
+
+	void setLoop(bool loop);
+	void setVolume(float volume);
+
+private:
+	void stream();
+	bool fillBuffer(unsigned buffer);
+
+private:
+	static constexpr unsigned BUFFER_COUNT = 4;
+	static constexpr std::size_t BUFFER_SIZE = 32 * 1024;
+
+	OggVorbis_File mFile;
+	bool mOpen;
+	unsigned mSource;
+	std::array<unsigned, BUFFER_COUNT> mBuffers;
+	unsigned mFormat;
+	unsigned mSampleRate;
+	std::vector<char> mChunk;
+
+	std::thread mThread;
+	std::atomic<bool> mStreaming;
+	std::atomic<bool> mPaused;
+	std::mutex mStateMutex;  // pause and resume of the source
+	std::atomic<bool> mLoop;
+};
@@ -3,8 +3,8 @@
 #include "player.hpp"
 
 #include "camera.hpp"
+#include "inputstate.hpp"
 #include "rendertarget.hpp"
-#include "window.hpp"
 
 namespace
 {
@@ -43,33 +43,35 @@ Player::Player(
 }
 
 void
-Player::update(Window &window, float dt)
+Player::update(const InputState &input, float dt)
 {
-	handleInput(dt, window);
+	mBaseSprite.savePreviousLocation();
+	mTurretSprite.savePreviousLocation();
+	handleInput(dt, input);
 	mBaseSprite.update(dt);
 	clampToWorld();
 	mTurretSprite.setLocation(mBaseSprite.getLocation());
 }
 
 void
-Player::draw(RenderTarget &target)
+Player::draw(RenderTarget &target, float alpha)
 {
-	target.draw(mBaseSprite);
-	target.draw(mTurretSprite);
+	target.draw(mBaseSprite, alpha);
+	target.draw(mTurretSprite, alpha);
 }
 
 void
-Player::handleInput(float dt, Window &window)
+Player::handleInput(float dt, const InputState &input)
 {
 	glm::vec2 moveAngle(0.f);
-	moveAngle += handleKeyboardMovements(window);
+	moveAngle += handleKeyboardMovements(input);
 	// TODO:
-	// moveAngle += handleGamePadMovements(window);
+	// moveAngle += handleGamePadMovements(input);
 
 	glm::vec2 fireAngle(0.f);
-	fireAngle += handleKeyboardShots(window);
+	fireAngle += handleKeyboardShots(input);
 	// TODO:
-	// fireAngle += handleGamePadShots(window);
+	// fireAngle += handleGamePadShots(input);
 
 	if (moveAngle != glm::vec2(0.f))
 	{
@@ -89,7 +91,7 @@ Player::handleInput(float dt, Window &window)
 }
 
 glm::vec2
-Player::handleKeyboardMovements(Window &window)
+Player::handleKeyboardMovements(const InputState &input)
 {
 	const glm::vec2 movements[] = {
 		{-1.f, -1.f}, {0.f, -1.f}, {1.f, -1.f},
@@ -97,44 +99,44 @@ Player::handleKeyboardMovements(Window &window)
 		{-1.f,  1.f}, {0.f,  1.f}, {1.f,  1.f},
 	};
 
-	int index = (window.isKeyPressed(GLFW_KEY_S) - window.isKeyPressed(GLFW_KEY_W) + 1) * 3
-		+ (window.isKeyPressed(GLFW_KEY_D) - window.isKeyPressed(GLFW_KEY_A) + 1);
+	int index = (input.isKeyDown(GLFW_KEY_S) - input.isKeyDown(GLFW_KEY_W) + 1) * 3
+		+ (input.isKeyDown(GLFW_KEY_D) - input.isKeyDown(GLFW_KEY_A) + 1);
 
 	return movements[index];
 }
 
 glm::vec2
-Player::handleKeyboardShots(Window &window)
+Player::handleKeyboardShots(const InputState &input)
 {
-	if (window.isKeyPressed(GLFW_KEY_KP_1))
+	if (input.isKeyDown(GLFW_KEY_KP_1))
 	{
 		return {-1.f, 1.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_2))
+	if (input.isKeyDown(GLFW_KEY_KP_2))
 	{
 		return {0.f, 1.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_3))
+	if (input.isKeyDown(GLFW_KEY_KP_3))
 	{
 		return {1.f, 1.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_4))
+	if (input.isKeyDown(GLFW_KEY_KP_4))
 	{
 		return {-1.f, 0.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_6))
+	if (input.isKeyDown(GLFW_KEY_KP_6))
 	{
 		return {1.f, 0.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_7))
+	if (input.isKeyDown(GLFW_KEY_KP_7))
 	{
 		return {-1.f, -1.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_8))
+	if (input.isKeyDown(GLFW_KEY_KP_8))
 	{
 		return {0.f, -1.f};
 	}
-	if (window.isKeyPressed(GLFW_KEY_KP_9))
+	if (input.isKeyDown(GLFW_KEY_KP_9))
 	{
 		return {1.f, -1.f};
 	}
@@ -5,8 +5,8 @@
 #include "sprite.hpp"
 
 class Camera;
+class InputState;
 class RenderTarget;
-class Window;
 
 class Player
 {
@@ -17,13 +17,18 @@ public:
 	       const FloatRect &turretRect, unsigned turretCount,
 	       glm::vec2 worldLocation);
 
-	void update(Window &window, float dt);
-	void draw(RenderTarget &target);
+	void update(const InputState &input, float dt);
+
+	/**
+	 * Draw the player at @alpha (0-1) of the way from the previous
+	 * update to the last one.
+	 */
+	void draw(RenderTarget &target, float alpha);
 
 private:
-	void handleInput(float dt, Window &window);
-	static glm::vec2 handleKeyboardMovements(Window &window);
-	static glm::vec2 handleKeyboardShots(Window &window);
+	void handleInput(float dt, const InputState &input);
+	static glm::vec2 handleKeyboardMovements(const InputState &input);
+	static glm::vec2 handleKeyboardShots(const InputState &input);
 	void clampToWorld();
 	void repositionCamera(float dt, glm::vec2 angle);
 
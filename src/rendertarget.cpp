@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 
@@ -29,6 +30,7 @@ static const std::uint16_t QuadIndices[] = { 0, 1, 2, 1, 3, 2 };
 RenderTarget::RenderTarget()
 	: mCamera(&mDefaultCamera)
 	, mTexture(nullptr)
+	, mBatchShader(nullptr)
 	, mVertexOffset(0)
 	, mIndexOffset(0)
 	, mVertexCount(0)
@@ -67,12 +69,23 @@ RenderTarget::use(const Window &window)
 	{
 		throw std::runtime_error("Cannot compile the shader");
 	}
+	mDistanceFieldShader.create();
+	if (!mDistanceFieldShader.attachFile(Shader::Type::Vertex, "assets/shaders/pos_uv_color.vs")
+	    || !mDistanceFieldShader.attachFile(Shader::Type::Fragment, "assets/shaders/sdf_color.fs")
+	    || !mDistanceFieldShader.link())
+	{
+		throw std::runtime_error("Cannot compile the distance field shader");
+	}
 
 	glm::vec2 size = window.getSize();
 	mDefaultCamera.setPosition({0.f, 0.f});
 	mDefaultCamera.setSize(size);
 	mCamera = &mDefaultCamera;
 
+	mDistanceFieldShader.use();
+	mDistanceFieldShader.getUniform("projection").setMatrix4(mCamera->getTransform());
+	mDistanceFieldShader.getUniform("image").setInteger(0);
+
 	mShader.use();
 	mShader.getUniform("projection").setMatrix4(mCamera->getTransform());
 	mShader.getUniform("image").setInteger(0);
@@ -145,6 +158,7 @@ RenderTarget::beginBatch()
 	mVertices.clear();
 	mIndices.clear();
 	mTexture = &mWhiteTexture;
+	mBatchShader = &mShader;
 	mVertexOffset = mIndexOffset = 0;
 	mVertexCount = mIndexCount = 0;
 }
@@ -154,6 +168,7 @@ RenderTarget::endBatch()
 {
 	mBatches.emplace_back(
 		mTexture,
+		mBatchShader,
 		mVertexOffset,
 		mIndexOffset,
 		mIndexCount-mIndexOffset);
@@ -197,8 +212,14 @@ RenderTarget::draw() const
 			     mIndices.data(),
 			     GL_STREAM_DRAW));
 
+	const Shader *shader = &mShader;
 	for (const auto &batch : mBatches)
 	{
+		if (batch.shader != shader)
+		{
+			shader = batch.shader;
+			shader->use();
+		}
 		batch.texture->bind(0);
 		glCheck(glDrawElementsBaseVertex(
 				GL_TRIANGLES,
@@ -207,6 +228,10 @@ RenderTarget::draw() const
 				reinterpret_cast<GLvoid*>(batch.indexOffset * sizeof(mIndices[0])),
 				batch.vertexOffset));
 	}
+	if (shader != &mShader)
+	{
+		mShader.use();
+	}
 	glCheck(glBindVertexArray(0));
 }
 
@@ -225,42 +250,62 @@ RenderTarget::setTexture(const Texture *texture)
 }
 
 void
-RenderTarget::draw(const std::string &text, Font &font, glm::vec2 pos, Color color)
+RenderTarget::setShader(const Shader *shader)
+{
+	if (shader != mBatchShader && mIndices.size() > mIndexOffset)
+	{
+		endBatch();
+	}
+	mBatchShader = shader;
+}
+
+void
+RenderTarget::draw(const std::string &text, Font &font, glm::vec2 pos, Color color,
+                   unsigned characterSize)
 {
 	if (text.empty())
 	{
 		return;
 	}
 
-	setTexture(&font.getTexture());
-	pos.y += font.getLineHeight();
-	auto codepoints = Utility::decodeUTF8(text);
-	for (auto codepoint : codepoints)
+	setShader(font.getMode() == Font::Mode::DistanceField
+	          ? &mDistanceFieldShader
+	          : &mShader);
+	float scale = font.getScale(characterSize);
+	pos.y += font.getLineHeight(characterSize);
+	// the buffer keeps its capacity, no allocation once warmed up
+	mCodepoints.resize(std::max(mCodepoints.size(), text.size()));
+	auto count = Utility::decodeUTF8(text, mCodepoints);
+	for (auto codepoint : std::span(mCodepoints).first(count))
 	{
+		// NOTE: get the glyph first, it may add a page to the font
+		const auto &glyph = font.getGlyph(codepoint);
+		setTexture(&font.getTexture(glyph.page));
 		reserve(4, QuadIndices);
 
-		const auto &glyph = font.getGlyph(codepoint);
-		pos.x += glyph.bearing.x;
-		pos.y -= glyph.bearing.y;
+		glm::vec2 bearing = glyph.bearing * scale;
+		pos.x += bearing.x;
+		pos.y -= bearing.y;
 		for (auto unit : QuadUnits)
 		{
 			mVertices.emplace_back(
-				glyph.size * unit + pos,
+				glyph.size * scale * unit + pos,
 				glyph.uvSize * unit + glyph.uvPos,
 				color);
 		}
-		pos.x += glyph.advance - glyph.bearing.x;
-		pos.y += glyph.bearing.y;
+		pos.x += glyph.advance * scale - bearing.x;
+		pos.y += bearing.y;
 	}
 }
 
 void
-RenderTarget::draw(const Sprite &sprite)
+RenderTarget::draw(const Sprite &sprite, float alpha)
 {
+	setShader(&mShader);
 	setTexture(&sprite.getTexture());
 	reserve(4, QuadIndices);
 	const auto &uvRect = sprite.getSource();
-	FloatRect dstRect = sprite.getDestination();
+	FloatRect dstRect = sprite.getDestination(alpha);
 	Color color = sprite.getTintColor();
 	float rotation = sprite.getRotation();
 	if (rotation == 0.f)
@@ -301,6 +346,7 @@ RenderTarget::draw(const TileMap &map)
 	glm::ivec2 start = map.getSquareByPixel(cameraStart);
 	glm::ivec2 end = map.getSquareByPixel(cameraEnd);
 
+	setShader(&mShader);
 	setTexture(&map.getTexture());
 	glm::ivec2 cur;
 	for (cur.x = start.x; cur.x <= end.x; cur.x++)
@@ -63,8 +63,19 @@ public:
 	 */
 	void draw() const;
 
-	void draw(const std::string &text, Font &font, glm::vec2 pos, Color color);
-	void draw(const Sprite &sprite);
+	/**
+	 * Draw the @text at @characterSize pixels, zero means the
+	 * size the @font was loaded with.
+	 */
+	void draw(const std::string &text, Font &font, glm::vec2 pos, Color color,
+	          unsigned characterSize = 0);
+
+	/**
+	 * Draw the @sprite at @alpha (0-1) of the way from its previous
+	 * location to the current one.
+	 */
+	void draw(const Sprite &sprite, float alpha = 1.f);
+
 	void draw(const TileMap &map);
 
 	/**
@@ -82,10 +93,14 @@ public:
 protected:
 	void initialize();
 
+private:
+	void setShader(const Shader *shader);
+
 private:
 	struct Batch
 	{
 		const Texture *texture;
+		const Shader *shader;
 		unsigned vertexOffset;
 		unsigned indexOffset;
 		unsigned indexCount;
@@ -98,7 +113,9 @@ private:
 	std::vector<Batch>         mBatches;
 	std::vector<Vertex>        mVertices;
 	std::vector<std::uint16_t> mIndices;
+	std::vector<char32_t>      mCodepoints;  // text being drawn
 	const Texture *mTexture;
+	const Shader *mBatchShader;
 	unsigned mVertexOffset;
 	unsigned mIndexOffset;
 	unsigned mVertexCount;
@@ -106,6 +123,7 @@ private:
 
 	Texture       mWhiteTexture;
 	Shader        mShader;
+	Shader        mDistanceFieldShader;
 	unsigned      mVBO;
 	unsigned      mEBO;
 	unsigned      mVAO;
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "resampler.hpp"
+
+namespace
+{
+// zero crossings of the sinc on each side of the center
+const int ZeroCrossings = 16;
+
+// kernel samples per input sample, interpolated linearly
+const int KernelResolution = 512;
+
+// fraction of the Nyquist frequency kept
+const double Rolloff = 0.95;
+
+double
+sinc(double x)
+{
+	if (x == 0.0)
+	{
+		return 1.0;
+	}
+	x *= std::numbers::pi;
+	return std::sin(x) / x;
+}
+
+double
+blackman(double u)
+{
+	// u in [-1, 1], 1 at the center
+	using std::numbers::pi;
+	return 0.42 + 0.5 * std::cos(pi * u) + 0.08 * std::cos(2.0 * pi * u);
+}
+}
+
+namespace Resampler
+{
+std::vector<float> resample(std::span<const float> input, double ratio)
+{
+	if (input.empty() || ratio <= 0.0)
+	{
+		return {};
+	}
+
+	// tabulate one side of the kernel, in input samples
+	const double cutoff = std::min(1.0, ratio) * Rolloff;
+	const int halfWidth = static_cast<int>(std::ceil(ZeroCrossings / cutoff));
+	std::vector<float> kernel(halfWidth * KernelResolution + 2, 0.f);
+	for (int i = 0; i < halfWidth * KernelResolution; ++i)
+	{
+		double x = static_cast<double>(i) / KernelResolution;
+		kernel[i] = cutoff * sinc(cutoff * x) * blackman(x / halfWidth);
+	}
+
+	const auto inputSize = static_cast<long>(input.size());
+	std::vector<float> output(static_cast<std::size_t>(input.size() * ratio));
+	const double step = 1.0 / ratio;
+	for (std::size_t n = 0; n < output.size(); ++n)
+	{
+		double t = n * step;
+		long center = static_cast<long>(t);
+		long first = std::max(center - halfWidth + 1, 0L);
+		long last = std::min(center + halfWidth, inputSize - 1);
+
+		float sum = 0.f;
+		for (long k = first; k <= last; ++k)
+		{
+			double d = std::abs(t - k) * KernelResolution;
+			auto i = static_cast<std::size_t>(d);
+			if (i + 1 >= kernel.size())
+			{
+				continue;
+			}
+			float frac = d - i;
+			sum += input[k] * (kernel[i] + frac * (kernel[i + 1] - kernel[i]));
+		}
+		output[n] = sum;
+	}
+	return output;
+}
+}
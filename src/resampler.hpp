@@ -0,0 +1,14 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+namespace Resampler
+{
+/**
+ * Resample @input by @ratio (output rate / input rate) with a
+ * Blackman windowed sinc filter, the cutoff follows the lower of
+ * the two rates to avoid aliasing when downsampling.
+ */
+std::vector<float> resample(std::span<const float> input, double ratio);
+}
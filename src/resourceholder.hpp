@@ -21,6 +21,7 @@ public:
 	Resource& get(Identifier id);
 	const Resource& get(Identifier id) const;
 
+	void destroy(Identifier id);
 	void destroy();
 
 private:
@@ -71,6 +72,17 @@ ResourceHolder<Resource, Identifier>::get(Identifier id) const
 	return *found->second;
 }
 
+template <typename Resource, typename Identifier>
+void
+ResourceHolder<Resource, Identifier>::destroy(Identifier id)
+{
+	auto found = mResourceMap.find(id);
+	assert(found != mResourceMap.end() && "Resource not found");
+
+	found->second->destroy();
+	mResourceMap.erase(found);
+}
+
 template <typename Resource, typename Identifier>
 void
 ResourceHolder<Resource, Identifier>::destroy()
@@ -6,15 +6,52 @@
 
 int main(int argc, char **argv)
 {
-	if(argc != 1)
+	auto mode = Application::InputMode::Live;
+	std::string inputFile;
+	bool lowLatency = false;
+	bool stats = false;
+	bool offlineAudio = false;
+	for (int i = 1; i < argc; ++i)
 	{
-		std::cerr << argv[0] << "takes no arguments.\n";
-		return 1;
+		std::string arg = argv[i];
+		if (arg == "--low-latency")
+		{
+			lowLatency = true;
+		}
+		else if (arg == "--stats")
+		{
+			stats = true;
+		}
+		else if (arg == "--offline-audio")
+		{
+			offlineAudio = true;
+		}
+		else if (arg == "--record" && i + 1 < argc
+		         && mode == Application::InputMode::Live)
+		{
+			mode = Application::InputMode::Record;
+			inputFile = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc
+		         && mode == Application::InputMode::Live)
+		{
+			mode = Application::InputMode::Replay;
+			inputFile = argv[++i];
+		}
+		else
+		{
+			std::cerr << "usage: " << argv[0]
+			          << " [--low-latency] [--stats] [--offline-audio]"
+			          << " [--record FILE | --replay FILE]\n";
+			return 1;
+		}
 	}
 
 	try
 	{
-		Application app;
+		Application app(mode, inputFile, offlineAudio);
+		app.setLowLatency(lowLatency);
+		app.setStatsReport(stats);
 		app.run();
 		return 0;
 	}
@@ -0,0 +1,188 @@
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#include "skylinepacker.hpp"
+
+SkylinePacker::SkylinePacker()
+	: mSkyline()
+	, mWidth(0)
+	, mHeight(0)
+{
+}
+
+void
+SkylinePacker::reset(unsigned width, unsigned height)
+{
+	mWidth = width;
+	mHeight = height;
+	mSkyline.clear();
+	if (width > 0)
+	{
+		mSkyline.push_back({0, 0, static_cast<int>(width)});
+	}
+}
+
+void
+SkylinePacker::grow(unsigned width, unsigned height)
+{
+	if (width > mWidth)
+	{
+		// the new column is empty up to the top
+		mSkyline.push_back({
+			static_cast<int>(mWidth),
+			0,
+			static_cast<int>(width - mWidth)
+		});
+		mWidth = width;
+	}
+	if (height > mHeight)
+	{
+		mHeight = height;
+	}
+}
+
+bool
+SkylinePacker::fit(std::size_t index, int width, int height, int &y) const
+{
+	int x = mSkyline[index].x;
+	if (x + width > static_cast<int>(mWidth))
+	{
+		return false;
+	}
+
+	// the rectangle rests on the highest node it spans
+	y = 0;
+	for (int left = width; left > 0; ++index)
+	{
+		const auto &node = mSkyline[index];
+		if (y < node.y)
+		{
+			y = node.y;
+		}
+		if (y + height > static_cast<int>(mHeight))
+		{
+			return false;
+		}
+		left -= node.width;
+	}
+	return true;
+}
+
+bool
+SkylinePacker::pack(unsigned width, unsigned height, glm::ivec2 &pos)
+{
+	int w = static_cast<int>(width);
+	int h = static_cast<int>(height);
+
+	// pick the position with the lowest top edge, on ties the
+	// narrowest node to limit the wasted space
+	std::size_t bestIndex = mSkyline.size();
+	int bestTop = std::numeric_limits<int>::max();
+	int bestWidth = std::numeric_limits<int>::max();
+	int bestY = 0;
+	for (std::size_t i = 0; i < mSkyline.size(); ++i)
+	{
+		int y;
+		if (!fit(i, w, h, y))
+		{
+			continue;
+		}
+		if (y + h < bestTop
+		    || (y + h == bestTop && mSkyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = y + h;
+			bestWidth = mSkyline[i].width;
+			bestY = y;
+		}
+	}
+	if (bestIndex == mSkyline.size())
+	{
+		return false;
+	}
+
+	pos.x = mSkyline[bestIndex].x;
+	pos.y = bestY;
+
+	// raise the skyline under the new rectangle
+	mSkyline.insert(mSkyline.begin() + bestIndex, {pos.x, bestTop, w});
+	for (std::size_t i = bestIndex + 1; i < mSkyline.size();)
+	{
+		auto &node = mSkyline[i];
+		int shrink = pos.x + w - node.x;
+		if (shrink <= 0)
+		{
+			break;
+		}
+		if (shrink < node.width)
+		{
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+		mSkyline.erase(mSkyline.begin() + i);
+	}
+
+	// merge the nodes at the same height
+	for (std::size_t i = 1; i < mSkyline.size();)
+	{
+		if (mSkyline[i - 1].y == mSkyline[i].y)
+		{
+			mSkyline[i - 1].width += mSkyline[i].width;
+			mSkyline.erase(mSkyline.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+	return true;
+}
+
+unsigned
+SkylinePacker::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned
+SkylinePacker::getHeight() const
+{
+	return mHeight;
+}
+
+const std::vector<SkylinePacker::Node>&
+SkylinePacker::getSkyline() const
+{
+	return mSkyline;
+}
+
+void
+SkylinePacker::setSkyline(unsigned width, unsigned height, std::vector<Node> skyline)
+{
+	assert(isValid(width, height, skyline) && "Invalid skyline");
+	mWidth = width;
+	mHeight = height;
+	mSkyline = std::move(skyline);
+}
+
+bool
+SkylinePacker::isValid(unsigned width, unsigned height,
+                       const std::vector<Node> &skyline)
+{
+	// fit() walks the nodes until it covers the rectangle, they
+	// must leave no hole up to the right edge
+	long x = 0;
+	for (const auto &node : skyline)
+	{
+		if (node.x != x || node.width <= 0
+		    || node.y < 0 || node.y > static_cast<long>(height)
+		    || x + node.width > static_cast<long>(width))
+		{
+			return false;
+		}
+		x += node.width;
+	}
+	return width == 0 ? skyline.empty() : x == static_cast<long>(width);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class SkylinePacker
+{
+public:
+	struct Node
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+public:
+	SkylinePacker();
+
+	/**
+	 * Forget every packed rectangle and start over with an empty
+	 * area of the given size.
+	 */
+	void reset(unsigned width, unsigned height);
+
+	/**
+	 * Grow the area keeping the rectangles already packed.
+	 */
+	void grow(unsigned width, unsigned height);
+
+	/**
+	 * Find a place for a rectangle of the given size using the
+	 * bottom-left skyline heuristic.
+	 *
+	 * @param[out] pos Top-left corner of the packed rectangle.
+	 *
+	 * @retval true the rectangle has been packed.
+	 * @retval false there is no space left for the rectangle.
+	 */
+	bool pack(unsigned width, unsigned height, glm::ivec2 &pos);
+
+	unsigned getWidth() const;
+	unsigned getHeight() const;
+
+	/**
+	 * Get or restore the skyline, used to save the state of an
+	 * area and continue packing into it later.
+	 */
+	const std::vector<Node>& getSkyline() const;
+	void setSkyline(unsigned width, unsigned height, std::vector<Node> skyline);
+
+	/**
+	 * Check that the @skyline is a list of contiguous nodes, left
+	 * to right, covering the whole width of the area.
+	 */
+	static bool isValid(unsigned width, unsigned height,
+	                    const std::vector<Node> &skyline);
+
+private:
+	bool fit(std::size_t index, int width, int height, int &y) const;
+
+private:
+	std::vector<Node> mSkyline;
+	unsigned mWidth;
+	unsigned mHeight;
+};
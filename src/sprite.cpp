@@ -18,6 +18,7 @@ Sprite::Sprite(
 	, mAnimated(true)
 	, mAnimatedWhenStopped(true)
 	, mLocation(location)
+	, mPreviousLocation(location)
 	, mVelocity(velocity)
 	, mRotation(0.f)
 	, mCollisionRadius(0.f)
@@ -44,6 +45,18 @@ Sprite::setLocation(glm::vec2 location)
 	mLocation = location;
 }
 
+void
+Sprite::savePreviousLocation()
+{
+	mPreviousLocation = mLocation;
+}
+
+glm::vec2
+Sprite::getPreviousLocation() const
+{
+	return mPreviousLocation;
+}
+
 glm::vec2
 Sprite::getSize() const
 {
@@ -134,6 +147,12 @@ Sprite::getDestination() const
 	return { mLocation, mFrameSize };
 }
 
+FloatRect
+Sprite::getDestination(float alpha) const
+{
+	return { glm::mix(mPreviousLocation, mLocation, alpha), mFrameSize };
+}
+
 FloatRect
 Sprite::getBoundingBox() const
 {
@@ -19,6 +19,13 @@ public:
 	glm::vec2 getLocation() const;
 	void setLocation(glm::vec2 location);
 
+	/**
+	 * Remember the current location as the location of the previous
+	 * simulation step, to interpolate between the two when drawing.
+	 */
+	void savePreviousLocation();
+	glm::vec2 getPreviousLocation() const;
+
 	glm::vec2 getSize() const;
 
 	glm::vec2 getVelocity() const;
@@ -41,6 +48,12 @@ public:
 	const FloatRect& getSource() const;
 	FloatRect getDestination() const;
 
+	/**
+	 * Get the destination at @alpha (0-1) of the way from the
+	 * previous location to the current one.
+	 */
+	FloatRect getDestination(float alpha) const;
+
 	FloatRect getBoundingBox() const;
 	bool isBoxColliding(const FloatRect &other) const;
 	bool isCircleColliding(glm::vec2 otherCenter, float otherRadius);
@@ -82,6 +95,7 @@ protected:
 
 	// position
 	glm::vec2 mLocation;
+	glm::vec2 mPreviousLocation;
 	glm::vec2 mVelocity;
 	float mRotation;
 
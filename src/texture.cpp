@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -7,8 +11,75 @@
 #include "texture.hpp"
 #include "stb_image.h"
 
+namespace
+{
+// textures loaded from a file, the only ones that can be evicted
+std::vector<const Texture*> evictableTextures;
+TextureStats stats{0, 0, SIZE_MAX, 0, 0};
+unsigned idleFramesBeforeEviction = 0;
+std::uint64_t currentFrame = 0;
+
+inline std::size_t
+getByteSize(unsigned width, unsigned height, Texture::Format format)
+{
+	std::size_t pixelSize = format == Texture::Format::Alpha ? 1 : 4;
+	return pixelSize * width * height;
+}
+
+inline GLenum
+getPixelFormat(Texture::Format format)
+{
+	return format == Texture::Format::Alpha ? GL_RED : GL_RGBA;
+}
+}
+
+Texture::~Texture()
+{
+	destroy();
+}
+
+Texture::Texture(Texture &&other) noexcept
+	: mTexture(std::exchange(other.mTexture, -1U))
+	, mWidth(std::exchange(other.mWidth, 0))
+	, mHeight(std::exchange(other.mHeight, 0))
+	, mFormat(other.mFormat)
+	, mRepeated(other.mRepeated)
+	, mSmooth(other.mSmooth)
+	, mPath(std::move(other.mPath))
+	, mLastUsed(other.mLastUsed)
+{
+	other.mPath.clear();
+	std::replace(evictableTextures.begin(), evictableTextures.end(),
+	             static_cast<const Texture*>(&other),
+	             static_cast<const Texture*>(this));
+}
+
+Texture&
+Texture::operator=(Texture &&other) noexcept
+{
+	if (this != &other)
+	{
+		// release the old texture instead of handing it to other
+		destroy();
+		mTexture = std::exchange(other.mTexture, -1U);
+		mWidth = std::exchange(other.mWidth, 0);
+		mHeight = std::exchange(other.mHeight, 0);
+		mFormat = other.mFormat;
+		mRepeated = other.mRepeated;
+		mSmooth = other.mSmooth;
+		mPath = std::move(other.mPath);
+		mLastUsed = other.mLastUsed;
+		other.mPath.clear();
+		std::replace(evictableTextures.begin(), evictableTextures.end(),
+		             static_cast<const Texture*>(&other),
+		             static_cast<const Texture*>(this));
+	}
+	return *this;
+}
+
 bool
-Texture::create(unsigned width, unsigned height, const void *pixels, bool repeat, bool smooth)
+Texture::create(unsigned width, unsigned height, const void *pixels,
+                bool repeat, bool smooth, Format format)
 {
 	if (width == 0 || height == 0)
 	{
@@ -17,45 +88,117 @@ Texture::create(unsigned width, unsigned height, const void *pixels, bool repeat
 		return false;
 	}
 
-	if (mTexture == -1U)
-	{
-		glCheck(glGenTextures(1, &mTexture));
-	}
+	// the storage is immutable, release the old one; the new
+	// content doesn't come from the file of the old one
+	destroy();
+
+	mWidth = width;
+	mHeight = height;
+	mFormat = format;
+	mRepeated = repeat;
+	mSmooth = smooth;
+	allocate(pixels);
+	return true;
+}
+
+void
+Texture::allocate(const void *pixels) const
+{
+	glCheck(glGenTextures(1, &mTexture));
 
 	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-	GLint parameter = repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	GLint parameter = mRepeated ? GL_REPEAT : GL_CLAMP_TO_EDGE;
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, parameter));
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, parameter));
 
-	parameter = smooth ? GL_LINEAR : GL_NEAREST;
+	parameter = mSmooth ? GL_LINEAR : GL_NEAREST;
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, parameter));
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, parameter));
 
-	glCheck(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height));
+	if (mFormat == Format::Alpha)
+	{
+		// store only the coverage and let the sampler expand it
+		// to white with alpha, so the shaders stay the same
+		const GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+		glCheck(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+		glCheck(glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, mWidth, mHeight));
+		glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+	else
+	{
+		glCheck(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, mWidth, mHeight));
+		glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
 	if (pixels)
 	{
 		glCheck(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
-		                        static_cast<GLsizei>(width),
-		                        static_cast<GLsizei>(height),
-		                        GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+		                        static_cast<GLsizei>(mWidth),
+		                        static_cast<GLsizei>(mHeight),
+		                        getPixelFormat(mFormat), GL_UNSIGNED_BYTE, pixels));
 	}
-	return true;
+
+	stats.memory += getByteSize(mWidth, mHeight, mFormat);
+	if (stats.peakMemory < stats.memory)
+	{
+		stats.peakMemory = stats.memory;
+	}
+	mLastUsed = currentFrame;
 }
 
 void
-Texture::destroy()
+Texture::release() const
 {
 	if (mTexture != -1U)
 	{
 		glCheck(glDeleteTextures(1, &mTexture));
 		mTexture = -1U;
+		stats.memory -= getByteSize(mWidth, mHeight, mFormat);
+	}
+}
+
+void
+Texture::destroy()
+{
+	release();
+	if (!mPath.empty())
+	{
+		std::erase(evictableTextures, this);
+		mPath.clear();
 	}
 }
 
+void
+Texture::evict() const
+{
+	release();
+	stats.evictions++;
+}
+
+void
+Texture::reload() const
+{
+	int width, height, channels;
+	auto *pixels = stbi_load(mPath.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cerr << "Texture::reload() - Cannot load " << mPath.string()
+			  << " (" << stbi_failure_reason() << ")."
+			  << std::endl;
+		return;
+	}
+	assert(static_cast<unsigned>(width) == mWidth
+	       && static_cast<unsigned>(height) == mHeight
+	       && "Texture size changed on disk");
+	allocate(pixels);
+	stbi_image_free(pixels);
+	stats.reloads++;
+}
+
 void
 Texture::update(const void *pixels)
 {
 	update(pixels, 0, 0, getWidth(), getHeight());
+	glCheck(glFlush());
 }
 
 void
@@ -70,6 +213,7 @@ Texture::update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned
 	}
 
 	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, mFormat == Format::Alpha ? 1 : 4));
 	glCheck(glTexSubImage2D(
 			GL_TEXTURE_2D,
 			0,
@@ -77,11 +221,42 @@ Texture::update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned
 			static_cast<GLint>(y),
 			static_cast<GLsizei>(w),
 			static_cast<GLsizei>(h),
-			GL_RGBA,
+			getPixelFormat(mFormat),
 			GL_UNSIGNED_BYTE,
 			pixels));
 	glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-	glCheck(glFlush());
+}
+
+void
+Texture::update(const void *pixels, std::span<const IntRect> rectangles)
+{
+	if (pixels == nullptr || mTexture == -1U || rectangles.empty())
+	{
+		return;
+	}
+
+	auto data = static_cast<const std::uint8_t *>(pixels);
+	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, mFormat == Format::Alpha ? 1 : 4));
+	for (const auto &rectangle : rectangles)
+	{
+		assert(rectangle.pos.x >= 0 && rectangle.pos.y >= 0
+		       && static_cast<unsigned>(rectangle.pos.x + rectangle.size.x) <= getWidth()
+		       && static_cast<unsigned>(rectangle.pos.y + rectangle.size.y) <= getHeight()
+		       && "Rectangle outside of the texture");
+		glCheck(glTexSubImage2D(
+				GL_TEXTURE_2D,
+				0,
+				rectangle.pos.x,
+				rectangle.pos.y,
+				rectangle.size.x,
+				rectangle.size.y,
+				getPixelFormat(mFormat),
+				GL_UNSIGNED_BYTE,
+				data));
+		data += getByteSize(rectangle.size.x, rectangle.size.y, mFormat);
+	}
+	glCheck(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
 void
@@ -100,6 +275,7 @@ Texture::update(const Texture &other, unsigned x, unsigned y)
 	{
 		return;
 	}
+	assert(mFormat == other.mFormat && "Texture formats are different");
 
 	GLint oldReadFB, oldDrawFB;
 	glCheck(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &oldReadFB));
@@ -149,6 +325,22 @@ Texture::update(const Texture &other, unsigned x, unsigned y)
 	glCheck(glDeleteFramebuffers(1, &sourceFB));
 }
 
+void
+Texture::getPixels(std::vector<std::uint8_t> &pixels) const
+{
+	pixels.resize(getByteSize(mWidth, mHeight, mFormat));
+	if (mTexture == -1U)
+	{
+		return;
+	}
+
+	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	glCheck(glPixelStorei(GL_PACK_ALIGNMENT, mFormat == Format::Alpha ? 1 : 4));
+	glCheck(glGetTexImage(GL_TEXTURE_2D, 0, getPixelFormat(mFormat),
+	                      GL_UNSIGNED_BYTE, pixels.data()));
+	glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
 bool
 Texture::loadFromFile(const std::filesystem::path &path)
 {
@@ -163,66 +355,54 @@ Texture::loadFromFile(const std::filesystem::path &path)
 	}
 	bool result = create(width, height, pixels);
 	stbi_image_free(pixels);
+	if (result)
+	{
+		evictableTextures.push_back(this);
+		mPath = path;
+	}
 	return result;
 }
 
 glm::vec2
 Texture::getSize() const
 {
-	glm::vec2 size(0);
-	if (mTexture != -1U)
-	{
-		GLint width, height;
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-		size.x = static_cast<float>(width);
-		size.y = static_cast<float>(height);
-	}
-	return size;
+	return glm::vec2(mWidth, mHeight);
 }
 
 unsigned
 Texture::getWidth() const
 {
-	GLint width = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width));
-	}
-	return width;
+	return mWidth;
 }
 
 unsigned
 Texture::getHeight() const
 {
-	GLint height = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height));
-	}
-	return height;
+	return mHeight;
+}
+
+Texture::Format
+Texture::getFormat() const
+{
+	return mFormat;
 }
 
 bool
 Texture::isRepeated() const
 {
-	GLint glWrapping = GL_CLAMP_TO_EDGE;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &glWrapping));
-	}
-	return glWrapping == GL_REPEAT;
+	return mRepeated;
 }
 
 void
 Texture::setRepeated(bool repeated)
 {
-	assert(mTexture != -1U && "Texture not created");
+	assert(mWidth != 0 && "Texture not created");
+
+	mRepeated = repeated;
+	if (mTexture == -1U)
+	{
+		return;
+	}
 
 	GLint glWrapping = repeated ? GL_REPEAT : GL_CLAMP_TO_EDGE;
 	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
@@ -234,19 +414,19 @@ Texture::setRepeated(bool repeated)
 bool
 Texture::isSmooth() const
 {
-	GLint glFiltering = GL_NEAREST;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &glFiltering));
-	}
-	return glFiltering == GL_LINEAR;
+	return mSmooth;
 }
 
 void
 Texture::setSmooth(bool smooth)
 {
-	assert(mTexture != -1U && "Texture not created");
+	assert(mWidth != 0 && "Texture not created");
+
+	mSmooth = smooth;
+	if (mTexture == -1U)
+	{
+		return;
+	}
 
 	GLint glFiltering = smooth ? GL_LINEAR : GL_NEAREST;
 	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
@@ -258,12 +438,64 @@ Texture::setSmooth(bool smooth)
 void
 Texture::bind() const
 {
-	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	if (mTexture == -1U && !mPath.empty())
+	{
+		reload();
+	}
+	mLastUsed = currentFrame;
+
+	// a failed reload leaves no texture, bind none
+	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture != -1U ? mTexture : 0));
 }
 
 void
-Texture::bind(int textureUnit) const noexcept
+Texture::bind(int textureUnit) const
 {
 	glCheck(glActiveTexture(GL_TEXTURE0 + textureUnit));
-	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	bind();
+}
+
+void
+Texture::setMemoryBudget(std::size_t bytes, unsigned idleFrames)
+{
+	stats.budget = bytes;
+	idleFramesBeforeEviction = idleFrames;
+}
+
+void
+Texture::endFrame()
+{
+	currentFrame++;
+	if (stats.memory <= stats.budget)
+	{
+		return;
+	}
+
+	std::vector<const Texture*> candidates;
+	for (auto texture : evictableTextures)
+	{
+		if (texture->mTexture != -1U
+		    && texture->mLastUsed + idleFramesBeforeEviction < currentFrame)
+		{
+			candidates.push_back(texture);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+	          [](const Texture *a, const Texture *b) {
+		          return a->mLastUsed < b->mLastUsed;
+	          });
+	for (auto texture : candidates)
+	{
+		if (stats.memory <= stats.budget)
+		{
+			break;
+		}
+		texture->evict();
+	}
+}
+
+TextureStats
+Texture::getStats()
+{
+	return stats;
 }
@@ -2,17 +2,46 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <filesystem>
+#include <span>
+#include <vector>
 
+#include "rect.hpp"
 #include "shader.hpp"
 
+struct TextureStats
+{
+	std::size_t memory;
+	std::size_t peakMemory;
+	std::size_t budget;
+	unsigned    evictions;
+	unsigned    reloads;
+};
+
 class Texture
 {
 public:
+	enum class Format
+	{
+		RGBA,   // 4 bytes per pixel
+		Alpha,  // 1 byte per pixel, sampled as white with alpha
+	};
+
+public:
+	Texture() = default;
+	~Texture();
+
+	Texture(const Texture &) = delete;
+	Texture(Texture &&other) noexcept;
+	Texture& operator=(const Texture &) = delete;
+	Texture& operator=(Texture &&other) noexcept;
+
 	bool loadFromFile(const std::filesystem::path &path);
 
 	bool create(unsigned width, unsigned height,
-	            const void *pixels=nullptr, bool repeat=false, bool smooth=true);
+	            const void *pixels=nullptr, bool repeat=false, bool smooth=true,
+	            Format format=Format::RGBA);
 
 	void destroy();
 
@@ -20,10 +49,22 @@ public:
 	void update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned h);
 	void update(const Texture &other, unsigned x = 0, unsigned y = 0);
 
+	/**
+	 * Upload many @rectangles binding the texture once, @pixels
+	 * holds their pixels one after the other in the same order.
+	 */
+	void update(const void *pixels, std::span<const IntRect> rectangles);
+
+	/**
+	 * Read back the pixels of the texture.
+	 */
+	void getPixels(std::vector<std::uint8_t> &pixels) const;
+
 	glm::vec2 getSize() const;
 
 	unsigned getWidth() const;
 	unsigned getHeight() const;
+	Format getFormat() const;
 
 	bool isRepeated() const;
 	void setRepeated(bool repeated);
@@ -31,9 +72,43 @@ public:
 	bool isSmooth() const;
 	void setSmooth(bool smooth);
 
+	/**
+	 * Bind the texture, reloading it from its source file if it
+	 * was evicted, and mark it as used in the current frame.
+	 */
 	void bind() const;
-	void bind(int textureUnit) const noexcept;
+	void bind(int textureUnit) const;
+
+	/**
+	 * Set the memory budget in bytes for all the textures and the
+	 * number of frames a texture loaded from a file must stay
+	 * unused before it can be evicted to honor the budget.
+	 */
+	static void setMemoryBudget(std::size_t bytes, unsigned idleFrames);
+
+	/**
+	 * Advance the frame counter and evict the least recently
+	 * used textures until the memory is back under the budget.
+	 */
+	static void endFrame();
+
+	static TextureStats getStats();
 
 private:
-	unsigned mTexture = -1U;
+	void allocate(const void *pixels) const;
+	void evict() const;
+	void reload() const;
+	void release() const;
+
+private:
+	mutable unsigned mTexture = -1U;
+	unsigned mWidth = 0;
+	unsigned mHeight = 0;
+	Format mFormat = Format::RGBA;
+	bool mRepeated = false;
+	bool mSmooth = true;
+
+	// eviction
+	std::filesystem::path mPath;
+	mutable std::uint64_t mLastUsed = 0;
 };
@@ -1,7 +1,15 @@
+#include <cassert>
+#include <cstdlib>
 #include <ctime>
 #include <random>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "utility.hpp"
 
@@ -9,10 +17,12 @@ namespace
 {
 std::default_random_engine createRandomEngine()
 {
-	auto seed = static_cast<unsigned long>(std::time(nullptr));
+	// every thread gets its own sequence
+	auto seed = static_cast<unsigned long>(std::time(nullptr))
+		^ std::hash<std::thread::id>()(std::this_thread::get_id());
 	return std::default_random_engine(seed);
 }
-auto randomEngine = createRandomEngine();
+thread_local auto randomEngine = createRandomEngine();
 
 // Copyright (c) 2008-2009 Bjoern Hoehrmann <bjoern@hoehrmann.de>
 // See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
@@ -68,6 +78,26 @@ std::string loadFile(const std::filesystem::path &file)
 	return buffer.str();
 }
 
+std::filesystem::path getUserCacheDirectory()
+{
+	// relative paths are invalid for the XDG specification
+	if (const char *xdg = std::getenv("XDG_CACHE_HOME");
+	    xdg && std::filesystem::path(xdg).is_absolute())
+	{
+		return xdg;
+	}
+	if (const char *home = std::getenv("HOME"); home && *home)
+	{
+		return std::filesystem::path(home) / ".cache";
+	}
+	return {};
+}
+
+void setRandomSeed(unsigned seed)
+{
+	randomEngine.seed(seed);
+}
+
 int randomInt(int exclusiveMax)
 {
 	std::uniform_int_distribution<> distr(0, exclusiveMax - 1);
@@ -82,22 +112,88 @@ float randomFloat(float exclusiveMax)
 
 std::u32string decodeUTF8(std::string_view str)
 {
-	std::u32string out;
-	out.reserve(str.size() * 4);
-	uint32_t codepoint;
-	uint32_t state = 0;
-	for (auto c : str)
+	std::u32string out(str.size(), 0);
+	out.resize(decodeUTF8(str, out));
+	return out;
+}
+
+std::size_t decodeUTF8(std::string_view str, std::span<char32_t> out)
+{
+	assert(out.size() >= str.size() && "Output too small for the codepoints");
+
+	auto p = reinterpret_cast<const unsigned char *>(str.data());
+	auto end = p + str.size();
+	char32_t *dst = out.data();
+	uint32_t codepoint = 0;
+	uint32_t state = UTF8_ACCEPT;
+	while (p != end)
 	{
-		if (!decode(&state, &codepoint, c))
+#ifdef __SSE2__
+		// widen 16 ASCII bytes at once, stop at the first
+		// block with a byte >= 0x80
+		const __m128i zero = _mm_setzero_si128();
+		while (end - p >= 16)
 		{
-			out.push_back(codepoint);
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			if (_mm_movemask_epi8(bytes))
+			{
+				break;
+			}
+			__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+			__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+			auto out128 = reinterpret_cast<__m128i *>(dst);
+			_mm_storeu_si128(out128 + 0, _mm_unpacklo_epi16(lo, zero));
+			_mm_storeu_si128(out128 + 1, _mm_unpackhi_epi16(lo, zero));
+			_mm_storeu_si128(out128 + 2, _mm_unpacklo_epi16(hi, zero));
+			_mm_storeu_si128(out128 + 3, _mm_unpackhi_epi16(hi, zero));
+			p += 16;
+			dst += 16;
+		}
+#endif
+		while (p != end && *p < 0x80)
+		{
+			*dst++ = *p++;
+		}
+
+		// one multibyte sequence through the DFA
+		while (p != end)
+		{
+			if (!decode(&state, &codepoint, *p++))
+			{
+				*dst++ = codepoint;
+				break;
+			}
+			if (state == UTF8_REJECT)
+			{
+				throw std::runtime_error("The string is not well-formed");
+			}
 		}
 	}
 	if (state != UTF8_ACCEPT)
 	{
 		throw std::runtime_error("The string is not well-formed");
 	}
-	return out;
+	return dst - out.data();
+}
+
+void UTF8Iterator::decodeNext()
+{
+	uint32_t codepoint = 0;
+	uint32_t state = UTF8_ACCEPT;
+	while (mNext != mEnd)
+	{
+		auto byte = static_cast<unsigned char>(*mNext++);
+		if (!decode(&state, &codepoint, byte))
+		{
+			mCodepoint = codepoint;
+			return;
+		}
+		if (state == UTF8_REJECT)
+		{
+			break;
+		}
+	}
+	throw std::runtime_error("The string is not well-formed");
 }
 
 }
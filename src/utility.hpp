@@ -1,12 +1,150 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <iterator>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace Utility
 {
 std::string loadFile(const std::filesystem::path &filename);
+
+/**
+ * Get the cache directory of the user, $XDG_CACHE_HOME or ~/.cache,
+ * empty when neither is set.
+ */
+std::filesystem::path getUserCacheDirectory();
+
+/**
+ * Restart the random sequence of the calling thread from @seed.
+ */
+void setRandomSeed(unsigned seed);
 int randomInt(int exclusiveMax);
 float randomFloat(float exclusiveMax);
 std::u32string decodeUTF8(std::string_view str);
+
+/**
+ * Decode the UTF-8 @str into @out without allocating, @out must
+ * have room for str.size() codepoints.
+ *
+ * @return the number of codepoints written.
+ */
+std::size_t decodeUTF8(std::string_view str, std::span<char32_t> out);
+
+/**
+ * Iterator over the codepoints of an UTF-8 string, it throws
+ * std::runtime_error when the string is not well-formed.
+ */
+class UTF8Iterator
+{
+public:
+	using iterator_category = std::input_iterator_tag;
+	using value_type = char32_t;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const char32_t *;
+	using reference = char32_t;
+
+public:
+	UTF8Iterator() = default;
+	UTF8Iterator(const char *begin, const char *end);
+
+	char32_t operator*() const;
+	UTF8Iterator& operator++();
+	UTF8Iterator operator++(int);
+
+	bool operator==(const UTF8Iterator &other) const;
+
+private:
+	void decodeNext();
+
+private:
+	const char *mPos = nullptr;
+	const char *mNext = nullptr;
+	const char *mEnd = nullptr;
+	char32_t mCodepoint = 0;
+};
+
+class UTF8Range
+{
+public:
+	explicit UTF8Range(std::string_view str);
+
+	UTF8Iterator begin() const;
+	UTF8Iterator end() const;
+
+private:
+	std::string_view mString;
+};
+
+inline
+UTF8Iterator::UTF8Iterator(const char *begin, const char *end)
+	: mPos(begin)
+	, mNext(begin)
+	, mEnd(end)
+{
+	++*this;
+}
+
+inline char32_t
+UTF8Iterator::operator*() const
+{
+	return mCodepoint;
+}
+
+inline UTF8Iterator&
+UTF8Iterator::operator++()
+{
+	mPos = mNext;
+	if (mNext == mEnd)
+	{
+		return *this;
+	}
+
+	// ASCII fast path, the DFA only for the multibyte sequences
+	if (auto byte = static_cast<unsigned char>(*mNext); byte < 0x80)
+	{
+		mCodepoint = byte;
+		++mNext;
+	}
+	else
+	{
+		decodeNext();
+	}
+	return *this;
+}
+
+inline UTF8Iterator
+UTF8Iterator::operator++(int)
+{
+	auto old = *this;
+	++*this;
+	return old;
+}
+
+inline bool
+UTF8Iterator::operator==(const UTF8Iterator &other) const
+{
+	return mPos == other.mPos;
+}
+
+inline
+UTF8Range::UTF8Range(std::string_view str)
+	: mString(str)
+{
+}
+
+inline UTF8Iterator
+UTF8Range::begin() const
+{
+	return { mString.data(), mString.data() + mString.size() };
+}
+
+inline UTF8Iterator
+UTF8Range::end() const
+{
+	auto end = mString.data() + mString.size();
+	return { end, end };
+}
 }
@@ -6,17 +6,23 @@
 #include "resources.hpp"
 
 class AudioDevice;
+class EventDispatcher;
+class InputState;
+class JobSystem;
 class SoundPlayer;
 class Window;
 class RenderTarget;
 
 struct Context
 {
-	AudioDevice   *audio;
-	Window        *window;
-	RenderTarget  *target;
-	FontHolder    *fonts;
-	TextureHolder *textures;
+	AudioDevice     *audio;
+	Window          *window;
+	InputState      *input;
+	EventDispatcher *events;
+	JobSystem       *jobs;
+	RenderTarget    *target;
+	FontHolder      *fonts;
+	TextureHolder   *textures;
 };
 
 class View
@@ -37,20 +43,12 @@ public:
 	 */
 	virtual bool update(float dt) = 0;
 
-	/**
-	 * Handle the passed event.
-	 *
-	 * @param[in] event Reference to the received event.
-	 *
-	 * @retval true event handled.
-	 * @retval false event not handled.
-	 */
-	virtual bool handleEvent(const Event &event) = 0;
-
 	/**
 	 * Render the view using the @target.
 	 *
 	 * @param[in] target Reference to a RenderTarget class.
+	 * @param[in] alpha Fraction of the next update already elapsed,
+	 *                  to interpolate from the previous state.
 	 */
-	virtual void render(RenderTarget &target) = 0;
+	virtual void render(RenderTarget &target, float alpha) = 0;
 };
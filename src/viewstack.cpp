@@ -1,8 +1,19 @@
 #include <cassert>
 
 #include "viewstack.hpp"
+#include "eventdispatcher.hpp"
 #include "rendertarget.hpp"
 
+namespace
+{
+// the views subscribe to the events with their own this
+const void *
+getOwner(const View::Ptr &view)
+{
+	return dynamic_cast<const void*>(view.get());
+}
+}
+
 ViewStack::ViewStack(const Context &context)
 	: mContext(context)
 {
@@ -29,27 +40,17 @@ ViewStack::update(float dt)
 bool
 ViewStack::handleEvent(const Event &event)
 {
-	bool handled = false;
-	for (auto it = mStack.rbegin(), end = mStack.rend();
-	     it != end;
-	     ++it)
-	{
-		handled = (*it)->handleEvent(event);
-		if (handled)
-		{
-			break;
-		}
-	}
+	bool handled = mContext.events->dispatch(event);
 	applyPendingChanges();
 	return handled;
 }
 
 void
-ViewStack::render(RenderTarget &target)
+ViewStack::render(RenderTarget &target, float alpha)
 {
 	for (auto &view: mStack)
 	{
-		view->render(target);
+		view->render(target, alpha);
 	}
 }
 
@@ -94,13 +95,20 @@ ViewStack::applyPendingChanges()
 		{
 		case Push:
 			mStack.push_back(createState(change.viewID));
+			mContext.events->setPriority(getOwner(mStack.back()),
+			                             mStack.size());
 			break;
 
 		case Pop:
+			mContext.events->unsubscribe(getOwner(mStack.back()));
 			mStack.pop_back();
 			break;
 
 		case Clear:
+			for (const auto &view : mStack)
+			{
+				mContext.events->unsubscribe(getOwner(view));
+			}
 			mStack.clear();
 			break;
 		}
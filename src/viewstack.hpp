@@ -18,8 +18,15 @@ public:
 	void registerView(ViewID view, Args&&... args);
 
 	bool update(float dt);
+
+	/**
+	 * Dispatch the @event to its subscribers, the views subscribe
+	 * to the events they need through Context::events with their
+	 * this as owner. The views get the priority of their position
+	 * in the stack and lose their listeners when removed.
+	 */
 	bool handleEvent(const Event &event);
-	void render(RenderTarget &target);
+	void render(RenderTarget &target, float alpha);
 
 	void pushView(ViewID viewID);
 	void popView();
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <span>
+
+#include "check.hpp"
+#include "tone.hpp"
+
+#include "audiodevice.hpp"
+#include "jobsystem.hpp"
+
+namespace
+{
+const unsigned SampleRate = 48000;
+
+// exit code of a skipped meson test
+const int SkipTest = 77;
+
+float
+getPeak(std::span<const float> samples)
+{
+	float peak = 0.f;
+	for (auto sample : samples)
+	{
+		peak = std::max(peak, std::abs(sample));
+	}
+	return peak;
+}
+
+bool
+openDevice(AudioDevice &device)
+{
+	if (!device.openLoopback(SampleRate))
+	{
+		return false;
+	}
+	device.setMasterVolume(100.f);
+	return true;
+}
+
+void
+testPlay(const std::filesystem::path &directory)
+{
+	AudioDevice device;
+	CHECK(openDevice(device));
+	CHECK(device.isLoopback());
+	CHECK(device.getSampleRate() == SampleRate);
+
+	auto path = directory / "tone.wav";
+	CHECK(tone::writeWav(path, 0.5f, SampleRate));
+	CHECK(device.load(SoundID::Shot1, path));
+
+	// nothing plays before the first play
+	auto samples = device.render(SampleRate / 10);
+	CHECK(samples.size() == SampleRate / 10 * 2);
+	CHECK(getPeak(samples) == 0.f);
+
+	device.play(SoundID::Shot1);
+	CHECK(getPeak(device.render(SampleRate / 10)) > 0.01f);
+}
+
+void
+testLoadAll(const std::filesystem::path &directory)
+{
+	AudioDevice device;
+	CHECK(openDevice(device));
+
+	// the files in the format of the device, to convert and missing
+	auto mono = directory / "mono.wav";
+	auto stereo = directory / "stereo.wav";
+	CHECK(tone::writeWav(mono, 0.5f, SampleRate));
+	CHECK(tone::writeWav(stereo, 0.5f, 44100, 2));
+
+	JobSystem jobs(2);
+	CHECK(!device.loadAll(jobs, {
+		{ SoundID::Shot1, mono },
+		{ SoundID::Shot2, stereo },
+		{ SoundID::Explosion1, directory / "missing.wav" },
+		{ SoundID::Explosion2, mono },
+	}));
+
+	// the sounds after the missing one are loaded too
+	for (auto id : { SoundID::Shot1, SoundID::Shot2, SoundID::Explosion2 })
+	{
+		device.stopAll();
+		device.render(SampleRate / 100);
+		device.play(id);
+		CHECK(getPeak(device.render(SampleRate / 10)) > 0.01f);
+	}
+}
+}
+
+int
+main()
+{
+	AudioDevice probe;
+	if (!probe.openLoopback(SampleRate))
+	{
+		// OpenAL without ALC_SOFT_loopback
+		return SkipTest;
+	}
+	probe.close();
+
+	auto directory = std::filesystem::temp_directory_path() / "robotrampage-test";
+	std::filesystem::create_directories(directory);
+	testPlay(directory);
+	testLoadAll(directory);
+	std::filesystem::remove_all(directory);
+	return checkResult();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Report the failed @condition and count it, main() returns the
+ * result of checkResult().
+ */
+#define CHECK(condition)                                              \
+	do                                                            \
+	{                                                             \
+		if (!(condition))                                     \
+		{                                                     \
+			std::cerr << __FILE__ << ":" << __LINE__      \
+			          << ": CHECK(" #condition ") failed\n"; \
+			checkFailures()++;                            \
+		}                                                     \
+	} while (0)
+
+inline int&
+checkFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+inline int
+checkResult()
+{
+	return checkFailures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+#include "check.hpp"
+
+#include "inputstate.hpp"
+
+namespace
+{
+// run the update steps of a frame like Application::run()
+unsigned
+runSteps(InputState &input, unsigned steps, int key)
+{
+	unsigned pressed = 0;
+	for (unsigned i = 0; i < steps; ++i)
+	{
+		pressed += input.isKeyPressed(key);
+		input.endStep();
+	}
+	return pressed;
+}
+
+void
+testFrameWithoutSteps()
+{
+	InputState input;
+
+	// pressed and released in a frame without steps
+	input.handleEvent(KeyPressed{nullptr, GLFW_KEY_SPACE, 0, 0});
+	input.handleEvent(KeyReleased{nullptr, GLFW_KEY_SPACE, 0, 0});
+	CHECK(runSteps(input, 0, GLFW_KEY_SPACE) == 0);
+
+	// the next step still sees both edges
+	CHECK(input.isKeyPressed(GLFW_KEY_SPACE));
+	CHECK(input.isKeyReleased(GLFW_KEY_SPACE));
+	CHECK(!input.isKeyDown(GLFW_KEY_SPACE));
+	CHECK(runSteps(input, 1, GLFW_KEY_SPACE) == 1);
+	CHECK(!input.isKeyReleased(GLFW_KEY_SPACE));
+}
+
+void
+testFrameWithManySteps()
+{
+	InputState input;
+
+	input.handleEvent(KeyPressed{nullptr, GLFW_KEY_A, 0, 0});
+	input.handleEvent(MouseButtonPressed{nullptr, GLFW_MOUSE_BUTTON_LEFT, 0});
+
+	// only the first step of the frame sees the edges
+	CHECK(input.isButtonPressed(GLFW_MOUSE_BUTTON_LEFT));
+	CHECK(runSteps(input, 2, GLFW_KEY_A) == 1);
+	CHECK(!input.isButtonPressed(GLFW_MOUSE_BUTTON_LEFT));
+
+	// the state survives the steps
+	CHECK(input.isKeyDown(GLFW_KEY_A));
+	CHECK(input.isButtonDown(GLFW_MOUSE_BUTTON_LEFT));
+}
+
+void
+testDefocus()
+{
+	InputState input;
+
+	input.handleEvent(KeyPressed{nullptr, GLFW_KEY_W, 0, 0});
+	input.endStep();
+	input.handleEvent(WindowDefocused{nullptr});
+	CHECK(!input.isKeyDown(GLFW_KEY_W));
+	CHECK(input.isKeyReleased(GLFW_KEY_W));
+}
+}
+
+int
+main()
+{
+	testFrameWithoutSteps();
+	testFrameWithManySteps();
+	testDefocus();
+	return checkResult();
+}
@@ -0,0 +1,81 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+
+#include "jobsystem.hpp"
+
+namespace
+{
+void
+testDependencies(JobSystem &jobs)
+{
+	std::vector<int> values(10000);
+	auto fill = jobs.parallelFor(values.size(), 0, [&values](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			values[i] = 1;
+		}
+	});
+
+	std::atomic<long> sum = 0;
+	JobSystem::Handle filled[] = { fill };
+	auto add = jobs.parallelFor(values.size(), 100, [&](std::size_t begin, std::size_t end) {
+		long partial = 0;
+		for (auto i = begin; i < end; ++i)
+		{
+			partial += values[i];
+		}
+		sum += partial;
+	}, filled);
+
+	jobs.wait(add);
+	CHECK(sum == static_cast<long>(values.size()));
+}
+
+void
+testException(JobSystem &jobs)
+{
+	bool skipped = true;
+	auto failing = jobs.schedule([] {
+		throw std::runtime_error("job failed");
+	});
+	JobSystem::Handle dependencies[] = { failing };
+	auto dependent = jobs.schedule([&skipped] {
+		skipped = false;
+	}, dependencies);
+
+	bool caught = false;
+	try
+	{
+		jobs.wait(dependent);
+	}
+	catch (const std::runtime_error &)
+	{
+		caught = true;
+	}
+	CHECK(caught);
+	CHECK(skipped);
+	CHECK(failing.isDone() && dependent.isDone());
+
+	// the workers survive the exception
+	std::atomic<int> count = 0;
+	jobs.wait(jobs.parallelFor(64, 1, [&count](std::size_t, std::size_t) {
+		count++;
+	}));
+	CHECK(count == 64);
+}
+}
+
+int
+main()
+{
+	for (unsigned threads = 1; threads <= 4; ++threads)
+	{
+		JobSystem jobs(threads);
+		testDependencies(jobs);
+		testException(jobs);
+	}
+	return checkResult();
+}
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "tone.hpp"
+
+#include "audiodevice.hpp"
+#include "jobsystem.hpp"
+
+namespace
+{
+const unsigned SampleRate = 48000;
+const unsigned SoundCount = 6;
+
+// exit code of a skipped meson test
+const int SkipTest = 77;
+
+typedef std::vector<std::pair<SoundID, std::filesystem::path>> SoundList;
+
+// milliseconds to load all the @sounds on a new loopback device
+template <typename Load>
+double
+measure(const SoundList &sounds, Load load)
+{
+	AudioDevice device;
+	if (!device.openLoopback(SampleRate))
+	{
+		return -1.0;
+	}
+	auto start = std::chrono::steady_clock::now();
+	CHECK(load(device, sounds));
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+}
+
+int
+main()
+{
+	// stereo at another rate, every file is mixed down and resampled
+	auto directory = std::filesystem::temp_directory_path() / "robotrampage-bench";
+	std::filesystem::create_directories(directory);
+	SoundList sounds;
+	for (unsigned i = 0; i < SoundCount; ++i)
+	{
+		auto path = directory / ("sound" + std::to_string(i) + ".wav");
+		CHECK(tone::writeWav(path, 2.f, 44100, 2));
+		sounds.emplace_back(static_cast<SoundID>(i), path);
+	}
+
+	double serial = measure(sounds, [](AudioDevice &device, const SoundList &sounds) {
+		bool success = true;
+		for (const auto &[id, path] : sounds)
+		{
+			success = device.load(id, path) && success;
+		}
+		return success;
+	});
+	JobSystem jobs;
+	double parallel = measure(sounds, [&jobs](AudioDevice &device, const SoundList &sounds) {
+		return device.loadAll(jobs, sounds);
+	});
+	std::filesystem::remove_all(directory);
+	if (serial < 0.0 || parallel < 0.0)
+	{
+		// OpenAL without ALC_SOFT_loopback
+		return SkipTest;
+	}
+
+	std::printf("%u sounds  load %8.2f ms  loadAll %8.2f ms (%u workers)\n",
+	            SoundCount, serial, parallel, jobs.getWorkerCount());
+	return checkResult();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <vector>
+
+namespace tone
+{
+template <typename T>
+void
+write(std::ostream &out, T value)
+{
+	out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * Write a 16-bit PCM WAV file with a 440 Hz tone of @seconds on
+ * every channel.
+ */
+inline bool
+writeWav(const std::filesystem::path &path, float seconds,
+         unsigned sampleRate, unsigned channels = 1)
+{
+	std::size_t frames = seconds * sampleRate;
+	std::vector<std::int16_t> samples(frames * channels);
+	for (std::size_t i = 0; i < frames; ++i)
+	{
+		auto sample = static_cast<std::int16_t>(16000.f * std::sin(
+			2.f * std::numbers::pi_v<float> * 440.f * i / sampleRate));
+		for (unsigned c = 0; c < channels; ++c)
+		{
+			samples[i * channels + c] = sample;
+		}
+	}
+	std::uint32_t dataSize = samples.size() * sizeof(samples[0]);
+	std::uint16_t blockAlign = channels * sizeof(samples[0]);
+
+	std::ofstream out(path, std::ios::out|std::ios::binary|std::ios::trunc);
+	out.write("RIFF", 4);
+	write<std::uint32_t>(out, 4 + 8 + 16 + 8 + dataSize);
+	out.write("WAVE", 4);
+	out.write("fmt ", 4);
+	write<std::uint32_t>(out, 16);
+	write<std::uint16_t>(out, 1);  // PCM
+	write<std::uint16_t>(out, channels);
+	write<std::uint32_t>(out, sampleRate);
+	write<std::uint32_t>(out, sampleRate * blockAlign);
+	write<std::uint16_t>(out, blockAlign);
+	write<std::uint16_t>(out, 16);
+	out.write("data", 4);
+	write<std::uint32_t>(out, dataSize);
+	out.write(reinterpret_cast<const char *>(samples.data()), dataSize);
+	return static_cast<bool>(out);
+}
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+
+#include "utility.hpp"
+
+namespace
+{
+// the decoder before the iterator and the span output: one byte at a
+// time through the DFA into a string reserved at 4x the input
+
+// Copyright (c) 2008-2009 Bjoern Hoehrmann <bjoern@hoehrmann.de>
+// See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
+
+const std::uint8_t utf8d[] = {
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 00..1f
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 20..3f
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 40..5f
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 60..7f
+	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, // 80..9f
+	7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7, // a0..bf
+	8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, // c0..df
+	0xa,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x4,0x3,0x3, // e0..ef
+	0xb,0x6,0x6,0x6,0x5,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8, // f0..ff
+	0x0,0x1,0x2,0x3,0x5,0x8,0x7,0x1,0x1,0x1,0x4,0x6,0x1,0x1,0x1,0x1, // s0..s0
+	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,0,1,0,1,1,1,1,1,1, // s1..s2
+	1,2,1,1,1,1,1,2,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1, // s3..s4
+	1,2,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,3,1,3,1,1,1,1,1,1, // s5..s6
+	1,3,1,1,1,1,1,3,1,3,1,1,1,1,1,1,1,3,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // s7..s8
+};
+
+std::uint32_t
+decode(std::uint32_t *state, std::uint32_t *codep, std::uint32_t byte)
+{
+	std::uint32_t type = utf8d[byte];
+
+	*codep = (*state != 0) ?
+		(byte & 0x3fu) | (*codep << 6) :
+		(0xff >> type) & (byte);
+
+	*state = utf8d[256 + *state*16 + type];
+	return *state;
+}
+
+std::u32string
+decodeReference(std::string_view str)
+{
+	std::u32string out;
+	out.reserve(str.size() * 4);
+	std::uint32_t codepoint;
+	std::uint32_t state = 0;
+	for (unsigned char c : str)
+	{
+		if (!decode(&state, &codepoint, c))
+		{
+			out.push_back(codepoint);
+		}
+	}
+	return out;
+}
+
+// about the length of the text drawn in a frame
+const std::size_t TextSize = 4096;
+const unsigned Iterations = 2000;
+
+std::string
+makeText(std::string_view pattern)
+{
+	std::string text;
+	while (text.size() < TextSize)
+	{
+		text += pattern;
+	}
+	return text;
+}
+
+template <typename Function>
+double
+measure(const std::string &text, Function fn)
+{
+	std::uint64_t sink = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < Iterations; ++i)
+	{
+		sink += fn(text);
+	}
+	std::chrono::duration<double, std::nano> elapsed =
+		std::chrono::steady_clock::now() - start;
+
+	// keep the work observable
+	volatile std::uint64_t keep = sink;
+	(void)keep;
+	return elapsed.count() / (Iterations * text.size());
+}
+
+void
+run(const char *name, const std::string &text)
+{
+	// all the decoders agree before being timed
+	auto expected = decodeReference(text);
+	std::u32string iterated(Utility::UTF8Range(text).begin(),
+	                        Utility::UTF8Range(text).end());
+	std::vector<char32_t> buffer(text.size());
+	auto count = Utility::decodeUTF8(text, buffer);
+	CHECK(iterated == expected);
+	CHECK(std::u32string(buffer.data(), count) == expected);
+
+	double reference = measure(text, [](const std::string &text) {
+		return decodeReference(text).size();
+	});
+	double range = measure(text, [](const std::string &text) {
+		std::uint64_t sum = 0;
+		for (auto codepoint : Utility::UTF8Range(text))
+		{
+			sum += codepoint;
+		}
+		return sum;
+	});
+	double span = measure(text, [&buffer](const std::string &text) {
+		return Utility::decodeUTF8(text, buffer);
+	});
+	std::printf("%-6s reference %6.3f ns/B  range %6.3f ns/B  span %6.3f ns/B\n",
+	            name, reference, range, span);
+}
+}
+
+int
+main()
+{
+	run("ascii", makeText("The quick brown fox jumps over the lazy dog. 0123456789\n"));
+	run("mixed", makeText("Score: 1200 \xc3\xa0\xc3\xa8 \xd0\xb6\xd0\xb8\xd0\xb7\xd0\xbd\xd1\x8c "
+	                      "\xe6\x97\xa5\xe6\x9c\xac \xf0\x9f\x98\x80 lives left\n"));
+	return checkResult();
+}
@@ -0,0 +1,87 @@
+#include "check.hpp"
+
+#include "eventdispatcher.hpp"
+#include "viewstack.hpp"
+
+namespace
+{
+struct Calls
+{
+	unsigned bottom = 0;
+	unsigned top = 0;
+	View *bottomView = nullptr;
+};
+
+class TestView: public View
+{
+public:
+	TestView(ViewStack &, const Context &context, unsigned *calls, Calls *all)
+		: mEvents(*context.events)
+		, mCalls(calls)
+	{
+		if (calls == &all->bottom)
+		{
+			all->bottomView = this;
+		}
+		subscribe();
+	}
+
+	void subscribe()
+	{
+		mEvents.subscribe<KeyPressed>(this, [this](const KeyPressed &) {
+			++*mCalls;
+			return true;
+		});
+	}
+
+	virtual bool update(float) override { return false; }
+	virtual void render(RenderTarget &, float) override {}
+
+private:
+	EventDispatcher &mEvents;
+	unsigned *mCalls;
+};
+
+const Event Key = KeyPressed{nullptr, 0, 0, 0};
+}
+
+int
+main()
+{
+	EventDispatcher events;
+	Context context{};
+	context.events = &events;
+
+	Calls calls;
+	ViewStack stack(context);
+	stack.registerView<TestView>(ViewID::Title, &calls.bottom, &calls);
+	stack.registerView<TestView>(ViewID::Playing, &calls.top, &calls);
+
+	// the top view handles the event first
+	stack.pushView(ViewID::Title);
+	stack.pushView(ViewID::Playing);
+	stack.update(0.f);
+	CHECK(stack.handleEvent(Key));
+	CHECK(calls.top == 1 && calls.bottom == 0);
+
+	// the popped view doesn't receive events anymore
+	stack.popView();
+	stack.update(0.f);
+	CHECK(stack.handleEvent(Key));
+	CHECK(calls.top == 1 && calls.bottom == 1);
+
+	// a lower view subscribing late still comes after the top
+	stack.pushView(ViewID::Playing);
+	stack.update(0.f);
+	static_cast<TestView*>(calls.bottomView)->subscribe();
+	CHECK(stack.handleEvent(Key));
+	CHECK(calls.top == 2 && calls.bottom == 1);
+
+	// nobody left to handle the event
+	stack.clearStack();
+	stack.update(0.f);
+	CHECK(!stack.handleEvent(Key));
+	CHECK(calls.top == 2 && calls.bottom == 1);
+
+	return checkResult();
+}